@@ -0,0 +1,172 @@
+/* robtk LV2 GUI
+ *
+ * Copyright 2013 Robin Gareus <robin@gareus.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/* damage regions
+ *
+ * a bounded list of non-overlapping rectangles.
+ * A new rectangle is merged into its bounding-box with every region
+ * it overlaps, and with adjacent regions if that adds no area.
+ * When the list is full, it is merged with the region for which
+ * the bounding-box adds the least area.
+ */
+
+#define RTK_DAMAGE_MAX 16
+
+typedef struct {
+	cairo_rectangle_t r[RTK_DAMAGE_MAX];
+	int cnt;
+} RtkDamage;
+
+static void rtk_damage_clear(RtkDamage *d) {
+	d->cnt = 0;
+}
+
+static bool rtk_damage_empty(const RtkDamage *d) {
+	return d->cnt == 0;
+}
+
+static void rtk_damage_full(RtkDamage *d, double width, double height) {
+	d->r[0].x = 0;
+	d->r[0].y = 0;
+	d->r[0].width = width;
+	d->r[0].height = height;
+	d->cnt = 1;
+}
+
+/* area added by combining a and b into one rectangle */
+static double rtk_damage_cost(const cairo_rectangle_t *a, const cairo_rectangle_t *b) {
+	cairo_rectangle_t u;
+	rect_combine(a, b, &u);
+	return u.width * u.height - a->width * a->height - b->width * b->height;
+}
+
+static void rtk_damage_add(RtkDamage *d, const cairo_rectangle_t *r) {
+	if (r->width <= 0 || r->height <= 0) return;
+	cairo_rectangle_t n = *r;
+
+	/* merge with overlapping and adjacent regions,
+	 * restart after each merge since the new region grew */
+	for (int i = 0; i < d->cnt; ) {
+		if (rect_intersect(&d->r[i], &n) || rtk_damage_cost(&d->r[i], &n) <= 0) {
+			rect_combine(&d->r[i], &n, &n);
+			d->r[i] = d->r[--d->cnt];
+			i = 0;
+			continue;
+		}
+		++i;
+	}
+
+	if (d->cnt < RTK_DAMAGE_MAX) {
+		d->r[d->cnt++] = n;
+		return;
+	}
+
+	/* list is full, merge with the cheapest region */
+	int best = 0;
+	double best_cost = rtk_damage_cost(&d->r[0], &n);
+	for (int i = 1; i < d->cnt; ++i) {
+		const double cost = rtk_damage_cost(&d->r[i], &n);
+		if (cost < best_cost) {
+			best_cost = cost;
+			best = i;
+		}
+	}
+	rect_combine(&d->r[best], &n, &n);
+	d->r[best] = d->r[--d->cnt];
+	rtk_damage_add(d, &n); // may overlap other regions now
+}
+
+static bool rtk_damage_intersects(const RtkDamage *d, const cairo_rectangle_t *r) {
+	for (int i = 0; i < d->cnt; ++i) {
+		if (rect_intersect(&d->r[i], r)) return true;
+	}
+	return false;
+}
+
+/* sum of all region areas */
+static double rtk_damage_area(const RtkDamage *d) {
+	double a = 0;
+	for (int i = 0; i < d->cnt; ++i) {
+		a += d->r[i].width * d->r[i].height;
+	}
+	return a;
+}
+
+/* damage submission
+ *
+ * queue_draw_*() may be called from any thread (e.g. the host's
+ * port_event), the regions are only accumulated in the GUI thread.
+ * Producers append to a lock-free multi-producer ring (gl/ringbuf.h),
+ * the GUI thread drains it into an RtkDamage list. Producers never
+ * block; if the queue is full the next frame is redrawn completely,
+ * so damage is never lost.
+ */
+
+#define RTK_DAMAGE_QUEUE 256
+
+typedef struct {
+	RtkRing *ring;
+	int      full; // redraw everything
+} RtkDamageQueue;
+
+static int rtk_damage_queue_init(RtkDamageQueue *q) {
+	q->ring = rtk_ring_alloc(sizeof(cairo_rectangle_t), RTK_DAMAGE_QUEUE);
+	q->full = 0;
+	return q->ring ? 0 : -1;
+}
+
+static void rtk_damage_queue_free(RtkDamageQueue *q) {
+	rtk_ring_free(q->ring);
+	q->ring = NULL;
+}
+
+/* any thread */
+static void rtk_damage_queue_full(RtkDamageQueue *q) {
+	__atomic_store_n(&q->full, 1, __ATOMIC_RELEASE);
+}
+
+/* any thread, returns false on overflow (full redraw is queued instead) */
+static bool rtk_damage_queue_push(RtkDamageQueue *q, const cairo_rectangle_t *r) {
+	if (rtk_ring_push(q->ring, r)) {
+		return true;
+	}
+	rtk_damage_queue_full(q);
+	return false;
+}
+
+/* GUI thread */
+static bool rtk_damage_queue_pending(RtkDamageQueue *q) {
+	return __atomic_load_n(&q->full, __ATOMIC_ACQUIRE) || rtk_ring_peek(q->ring);
+}
+
+/* GUI thread: move queued regions to d,
+ * a full redraw covers width x height */
+static void rtk_damage_queue_drain(RtkDamageQueue *q, RtkDamage *d, double width, double height) {
+	const bool full = __atomic_exchange_n(&q->full, 0, __ATOMIC_ACQ_REL);
+	const cairo_rectangle_t *r;
+	while ((r = (const cairo_rectangle_t*) rtk_ring_peek(q->ring))) {
+		if (!full) {
+			rtk_damage_add(d, r);
+		}
+		rtk_ring_commit(q->ring);
+	}
+	if (full) {
+		rtk_damage_full(d, width, height);
+	}
+}
@@ -0,0 +1,214 @@
+/* robtk LV2 GUI
+ *
+ * Copyright 2013 Robin Gareus <robin@gareus.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/* pointer hit-test index
+ *
+ * containers with many children get a uniform grid of buckets over
+ * the children's bounding box, rebuilt after layout. Every bucket
+ * lists the children overlapping it in child order, a lookup only
+ * tests the children of one bucket: O(1) for boxes and tables.
+ * Packing a child drops the index, robwidget_child_at() falls back
+ * to a linear scan until it is rebuilt.
+ *
+ * The grid resolution follows the layout: one column per group of
+ * children overlapping horizontally, one row per group overlapping
+ * vertically. An hbox gets a column per child, a table its rows x cols.
+ *
+ * Hidden children have a stale area and are kept in an extra bucket
+ * which is always checked, they may be shown before the next layout.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#define RTK_HIT_INDEX_MIN 8 // fewer children: linear scan
+
+typedef struct {
+	float x0, y0; // bounding box origin
+	float bw, bh; // bucket size
+	int gx, gy;   // grid size
+	unsigned int *offset; // gx * gy + 2, start of each bucket in 'child', last: hidden
+	unsigned int *child;  // child indices
+} RtkHitIndex;
+
+static void rtk_hit_index_free(RobWidget *rw) {
+	RtkHitIndex *hi = (RtkHitIndex*) rw->hit_index;
+	if (!hi) return;
+	free(hi->offset);
+	free(hi->child);
+	free(hi);
+	rw->hit_index = NULL;
+}
+
+static inline int rtk_hit_index_bucket(float v, float v0, float bs, int n) {
+	const int b = floorf((v - v0) / bs);
+	return b < 0 ? 0 : (b >= n ? n - 1 : b);
+}
+
+static int rtk_hit_index_cmp(const void *a, const void *b) {
+	const float x = *(const float*)a;
+	const float y = *(const float*)b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/* number of groups of overlapping intervals,
+ * iv: m pairs [start, end], sorted in place */
+static int rtk_hit_index_groups(float *iv, unsigned int m) {
+	if (m == 0) return 1;
+	qsort(iv, m, 2 * sizeof(float), rtk_hit_index_cmp);
+	int cnt = 1;
+	float end = iv[1];
+	for (unsigned int i = 1; i < m; ++i) {
+		if (iv[2 * i] >= end) {
+			++cnt;
+			end = iv[2 * i + 1];
+		} else {
+			end = MAX(end, iv[2 * i + 1]);
+		}
+	}
+	return cnt;
+}
+
+/* call after the children's areas are final */
+static void rtk_hit_index_build(RobWidget *rw) {
+	rtk_hit_index_free(rw);
+	const unsigned int n = rw->childcount;
+	if (n < RTK_HIT_INDEX_MIN) return;
+
+	float *ivx = (float*) malloc(4 * n * sizeof(float));
+	if (!ivx) return;
+	float *ivy = &ivx[2 * n];
+
+	float x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+	unsigned int m = 0;
+	for (unsigned int i = 0; i < n; ++i) {
+		const RobWidget *c = rw->children[i];
+		if (c->hidden) continue;
+		const cairo_rectangle_t *a = &c->area;
+		if (m == 0) {
+			x0 = x1 = a->x;
+			y0 = y1 = a->y;
+		}
+		x0 = MIN(x0, a->x); x1 = MAX(x1, a->x + a->width);
+		y0 = MIN(y0, a->y); y1 = MAX(y1, a->y + a->height);
+		ivx[2 * m] = a->x; ivx[2 * m + 1] = a->x + a->width;
+		ivy[2 * m] = a->y; ivy[2 * m + 1] = a->y + a->height;
+		++m;
+	}
+
+	int gx = rtk_hit_index_groups(ivx, m);
+	int gy = rtk_hit_index_groups(ivy, m);
+	free(ivx);
+	if (x1 <= x0) gx = 1;
+	if (y1 <= y0) gy = 1;
+	while (gx * gy > 4 * (int)n) {
+		if (gx >= gy) gx = (gx + 1) / 2;
+		else gy = (gy + 1) / 2;
+	}
+
+	RtkHitIndex *hi = (RtkHitIndex*) calloc(1, sizeof(RtkHitIndex));
+	if (!hi) return;
+	const int nb = gx * gy;
+	hi->x0 = x0; hi->y0 = y0;
+	hi->bw = x1 > x0 ? (x1 - x0) / gx : 1;
+	hi->bh = y1 > y0 ? (y1 - y0) / gy : 1;
+	hi->gx = gx; hi->gy = gy;
+	rw->hit_index = hi;
+
+	hi->offset = (unsigned int*) calloc(nb + 2, sizeof(unsigned int));
+	unsigned int *fill = (unsigned int*) malloc((nb + 1) * sizeof(unsigned int));
+	if (!hi->offset || !fill) {
+		free(fill);
+		rtk_hit_index_free(rw);
+		return;
+	}
+
+	/* count, then fill, children are added in order */
+	for (int pass = 0; pass < 2; ++pass) {
+		if (pass == 1) {
+			for (int b = 0; b <= nb; ++b) {
+				hi->offset[b + 1] += hi->offset[b];
+			}
+			hi->child = (unsigned int*) malloc(MAX(1, hi->offset[nb + 1]) * sizeof(unsigned int));
+			if (!hi->child) {
+				free(fill);
+				rtk_hit_index_free(rw);
+				return;
+			}
+			memcpy(fill, hi->offset, (nb + 1) * sizeof(unsigned int));
+		}
+		for (unsigned int i = 0; i < n; ++i) {
+			const RobWidget *c = rw->children[i];
+			if (c->hidden) {
+				if (pass == 0) {
+					++hi->offset[nb + 1];
+				} else {
+					hi->child[fill[nb]++] = i;
+				}
+				continue;
+			}
+			const cairo_rectangle_t *a = &c->area;
+			const int bx0 = rtk_hit_index_bucket(a->x, x0, hi->bw, gx);
+			const int bx1 = rtk_hit_index_bucket(a->x + a->width, x0, hi->bw, gx);
+			const int by0 = rtk_hit_index_bucket(a->y, y0, hi->bh, gy);
+			const int by1 = rtk_hit_index_bucket(a->y + a->height, y0, hi->bh, gy);
+			for (int by = by0; by <= by1; ++by) {
+				for (int bx = bx0; bx <= bx1; ++bx) {
+					if (pass == 0) {
+						++hi->offset[by * gx + bx + 1];
+					} else {
+						hi->child[fill[by * gx + bx]++] = i;
+					}
+				}
+			}
+		}
+	}
+	free(fill);
+}
+
+/* index of the first visible child in bucket b
+ * whose area contains x, y (inclusive), UINT_MAX if none */
+static unsigned int rtk_hit_index_scan(RobWidget *rw, const RtkHitIndex *hi, int b, int x, int y) {
+	for (unsigned int i = hi->offset[b]; i < hi->offset[b + 1]; ++i) {
+		const RobWidget *c = rw->children[hi->child[i]];
+		if (c->hidden) continue;
+		if (x >= c->area.x && y >= c->area.y
+				&& x <= c->area.x + c->area.width
+				&& y <= c->area.y + c->area.height
+			 ) {
+			return hi->child[i];
+		}
+	}
+	return UINT_MAX;
+}
+
+/* first visible child whose area contains x, y, same as a linear scan */
+static RobWidget * rtk_hit_index_find(RobWidget *rw, int x, int y) {
+	const RtkHitIndex *hi = (const RtkHitIndex*) rw->hit_index;
+	const int nb = hi->gx * hi->gy;
+	const int b = rtk_hit_index_bucket(y, hi->y0, hi->bh, hi->gy) * hi->gx
+		+ rtk_hit_index_bucket(x, hi->x0, hi->bw, hi->gx);
+	unsigned int i = rtk_hit_index_scan(rw, hi, b, x, y);
+	if (hi->offset[nb] < hi->offset[nb + 1]) {
+		i = MIN(i, rtk_hit_index_scan(rw, hi, nb, x, y));
+	}
+	return i < rw->childcount ? rw->children[i] : NULL;
+}
@@ -87,12 +87,10 @@ static void rob_table_resize(struct rob_table *rt, unsigned int nrows, unsigned
 	}
 }
 
-static void robwidget_position_cache(RobWidget *rw) {
-	RobTkBtnEvent e;
-	e.x = 0; e.y = 0;
-	offset_traverse_from_child(rw, &e);
-
-	rw->trel.x = e.x; rw->trel.y = e.y;
+/* px, py: absolute position of the parent */
+static void robwidget_position_cache(RobWidget *rw, const float px, const float py) {
+	rw->trel.x = px + rw->area.x;
+	rw->trel.y = py + rw->area.y;
 	rw->trel.width  = rw->area.width;
 	rw->trel.height = rw->area.height;
 	rw->resized = TRUE;
@@ -144,6 +142,9 @@ static void rcontainer_child_pack(RobWidget *rw, RobWidget *chld, bool expand, b
 	rw->children[rw->childcount] = chld;
 	rw->childcount++;
 	chld->parent = rw;
+	robwidget_set_top(chld, rw->top);
+	rtk_hit_index_free(rw); // linear scan until the next layout
+	robwidget_layout_invalidate(rw);
 }
 static void rcontainer_clear_bg(RobWidget* rw, cairo_t* cr, cairo_rectangle_t *ev) {
   cairo_rectangle (cr, ev->x, ev->y, ev->width, ev->height);
@@ -160,7 +161,24 @@ static void rcontainer_clear_bg(RobWidget* rw, cairo_t* cr, cairo_rectangle_t *e
 #endif
   cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
   cairo_set_source_rgb (cr, c[0], c[1], c[2]);
-  cairo_rectangle (cr, 0, 0, ev->width, ev->height);
+  cairo_rectangle (cr, ev->x, ev->y, ev->width, ev->height);
+#ifdef DEBUG_OVERDRAW
+  rtk_overdraw_add(cr, ev->x, ev->y, ev->width, ev->height, 1);
+#endif
+
+  /* leave out opaque children, they paint their own background.
+   * The reverse winding cuts a hole into the rectangle above */
+  for (unsigned int i=0; i < rw->childcount; ++i) {
+    RobWidget * c = (RobWidget *) rw->children[i];
+    if (c->hidden || !c->opaque) continue;
+#ifndef PUGL_XSHM
+    if (c->layer && c->childcount == 0) continue; // not drawn into the canvas
+#endif
+    cairo_rectangle (cr, c->area.x + c->area.width, c->area.y, -c->area.width, c->area.height);
+#ifdef DEBUG_OVERDRAW
+    rtk_overdraw_add(cr, c->area.x, c->area.y, c->area.width, c->area.height, -1);
+#endif
+  }
   cairo_fill(cr);
 }
 
@@ -211,6 +229,8 @@ static RobWidget* rcontainer_mousescroll(RobWidget* handle, RobTkBtnEvent *ev) {
 	return c->mousescroll(c, &event);
 }
 
+/* ev is in the container's coordinates, children
+ * are exposed with the intersection in theirs */
 static bool rcontainer_expose_event_no_clear(RobWidget* rw, cairo_t* cr, cairo_rectangle_t *ev) {
 
 	for (unsigned int i=0; i < rw->childcount; ++i) {
@@ -219,15 +239,10 @@ static bool rcontainer_expose_event_no_clear(RobWidget* rw, cairo_t* cr, cairo_r
 		if (c->hidden) continue;
 		if (!rect_intersect(&c->area, ev)) continue;
 
-		if (rw->resized) {
-			// XXX alternatively set  c->resized = TRUE
-			memcpy(&event, ev, sizeof(cairo_rectangle_t));
-		} else {
-			event.x = MAX(0, ev->x - c->area.x);
-			event.y = MAX(0, ev->y - c->area.y);
-			event.width  = MIN(c->area.x + c->area.width, ev->x + ev->width) - MAX(ev->x,  c->area.x);
-			event.height = MIN(c->area.y + c->area.height, ev->y + ev->height) - MAX(ev->y, c->area.y);
-		}
+		event.x = MAX(0, ev->x - c->area.x);
+		event.y = MAX(0, ev->y - c->area.y);
+		event.width  = MIN(c->area.x + c->area.width, ev->x + ev->width) - MAX(ev->x,  c->area.x);
+		event.height = MIN(c->area.y + c->area.height, ev->y + ev->height) - MAX(ev->y, c->area.y);
 #ifdef DEBUG_EXPOSURE_UI
 		printf("rce %.1f+%.1f , %.1fx%.1f  ||  cld %.1f+%.1f ,  %.1fx%.1f || ISC %.1f+%.1f , %.1fx%.1f\n",
 				ev->x, ev->y, ev->width, ev->height,
@@ -236,7 +251,7 @@ static bool rcontainer_expose_event_no_clear(RobWidget* rw, cairo_t* cr, cairo_r
 #endif
 		cairo_save(cr);
 		cairo_translate(cr, c->area.x, c->area.y);
-		c->expose_event(c, cr, &event);
+		robwidget_expose(c, cr, &event);
 #if 0 // VISUAL LAYOUT DEBUG -- NB. expose_event may or may not alter event
 		cairo_rectangle(cr, event.x, event.y, event.width, event.height);
 		cairo_set_source_rgba(cr, rand()/(float)RAND_MAX, rand()/(float)RAND_MAX, rand()/(float)RAND_MAX, 0.5);
@@ -244,21 +259,16 @@ static bool rcontainer_expose_event_no_clear(RobWidget* rw, cairo_t* cr, cairo_r
 #endif
 		cairo_restore(cr);
 	}
-	if (rw->resized) {
-		rw->resized = FALSE;
-	}
 	return TRUE;
 }
 
+/* after a (re)layout the background is cleared once, in all
+ * damaged regions of the frame. 'resized' is reset by the
+ * toplevel after the frame, see cairo_expose() */
 static bool rcontainer_expose_event(RobWidget* rw, cairo_t* cr, cairo_rectangle_t *ev) {
 	if (rw->resized) {
-		cairo_rectangle_t event;
-		event.x = MAX(0, ev->x - rw->area.x);
-		event.y = MAX(0, ev->y - rw->area.y);
-		event.width  = MIN(rw->area.x + rw->area.width , ev->x + ev->width)   - MAX(ev->x, rw->area.x);
-		event.height = MIN(rw->area.y + rw->area.height, ev->y + ev->height) - MAX(ev->y, rw->area.y);
 		cairo_save(cr);
-		rcontainer_clear_bg(rw, cr, &event);
+		rcontainer_clear_bg(rw, cr, ev);
 		cairo_restore(cr);
 	}
 	return rcontainer_expose_event_no_clear(rw, cr, ev);
@@ -283,7 +293,7 @@ rhbox_size_request(RobWidget* rw, int *w, int *h) {
 		int cw, ch;
 		RobWidget * c = (RobWidget *) rw->children[i];
 		if (c->hidden) continue;
-		c->size_request(c, &cw, &ch);
+		robwidget_size_request(c, &cw, &ch);
 		if (homogeneous) {
 			ww = MAX(cw, ww);
 		} else {
@@ -370,7 +380,7 @@ static void rhbox_size_allocate(RobWidget* rw, int w, int h) {
 		RobWidget * c = (RobWidget *) rw->children[i];
 		if (c->hidden) continue;
 		if (c->size_allocate) {
-			c->size_allocate(c, 
+			robwidget_size_allocate(c,
 					c->area.width + ((grow || !roblayout_can_expand(c)) ? 0 : floorf(xtra_space)),
 					roblayout_can_fill(c) ? h : hh);
 		}
@@ -464,7 +474,7 @@ static void rvbox_size_request(RobWidget* rw, int *w, int *h) {
 		int cw, ch;
 		RobWidget * c = (RobWidget *) rw->children[i];
 		if (c->hidden) continue;
-		c->size_request(c, &cw, &ch);
+		robwidget_size_request(c, &cw, &ch);
 		ww = MAX(cw, ww);
 		if (homogeneous) {
 			hh = MAX(ch, hh);
@@ -554,7 +564,7 @@ static void rvbox_size_allocate(RobWidget* rw, int w, int h) {
 		RobWidget * c = (RobWidget *) rw->children[i];
 		if (c->hidden) continue;
 		if (c->size_allocate) {
-			c->size_allocate(c, roblayout_can_expand(c) ? w : ww,
+			robwidget_size_allocate(c, roblayout_can_expand(c) ? w : ww,
 					c->area.height + ((grow || !roblayout_can_expand(c)) ? 0 : floorf(xtra_space)));
 		}
 #ifdef DEBUG_VBOX
@@ -683,7 +693,7 @@ rtable_size_request(RobWidget* rw, int *w, int *h) {
 		struct rob_table_child *tc = &rt->chld[i];
 		RobWidget * c = (RobWidget *) tc->rw;
 		if (c->hidden) continue;
-		c->size_request(c, &cw, &ch);
+		robwidget_size_request(c, &cw, &ch);
 		bool can_expand = roblayout_can_expand(c);
 #ifdef DEBUG_TABLE
 		printf("widget %d wants (%d x %d) x-span:%d y-span: %d\n", i, cw, ch, (tc->right - tc->left), (tc->bottom - tc->top));
@@ -831,7 +841,7 @@ static void rtable_size_allocate(RobWidget* rw, int w, int h) {
 			ch += rt->rows[span_y].req_h;
 		}
 #else
-		c->size_request(c, &cw, &ch);
+		robwidget_size_request(c, &cw, &ch);
 #endif
 
 #ifdef DEBUG_TABLE
@@ -847,7 +857,7 @@ static void rtable_size_allocate(RobWidget* rw, int w, int h) {
 			for (int tri = tc->top; tri < tc->bottom; ++tri) {
 				if (rt->rows[tri].req_h != 0 && rt->rows[tri].is_expandable_y) xpandy++;
 			}
-			c->size_allocate(c,
+			robwidget_size_allocate(c,
 					cw + floorf(xtra_width * xpandx),
 					ch + floorf(xtra_height * xpandy));
 #if 0
@@ -913,7 +923,7 @@ static void rtable_size_allocate(RobWidget* rw, int w, int h) {
 			int ah = c->area.height;
 			if (tc->expand_x & RTK_FILL) aw = MAX(cw,aw);
 			if (tc->expand_y & RTK_FILL) ah = MAX(ch,ah);
-			c->size_allocate(c, aw, ah);
+			robwidget_size_allocate(c, aw, ah);
 #ifdef DEBUG_TABLE
 			printf("TABLECHILD %d reloc %dx%d at %d+%d (wsize: %.1fx%.1f)\n", i, cw, ch, cx, cy, c->area.width, c->area.height);
 #endif
@@ -1022,16 +1032,144 @@ static void rob_table_destroy(RobWidget * rw) {
 	robwidget_destroy(rw);
 }
 
-/* recursive childpos cache */
 static void
-rtoplevel_cache(RobWidget* rw, bool valid) {
+rtoplevel_cache_at(RobWidget* rw, bool valid, const float px, const float py) {
+	robwidget_position_cache(rw, px, py);
+	rw->cached_position = valid;
+	rtk_hit_index_build(rw);
 	for (unsigned int i=0; i < rw->childcount; ++i) {
 		RobWidget * c = (RobWidget *) rw->children[i];
-		if (c->hidden) {
-			valid= FALSE;
+		rtoplevel_cache_at(c, valid && !c->hidden, rw->trel.x, rw->trel.y);
+	}
+}
+
+/* childpos cache and hit-test index, top-down in a single pass.
+ * For a subtree the cached position of its parent is used */
+static void
+rtoplevel_cache(RobWidget* rw, bool valid) {
+	if (rw->parent && rw->parent != rw) {
+		rtoplevel_cache_at(rw, valid, rw->parent->trel.x, rw->parent->trel.y);
+	} else {
+		rtoplevel_cache_at(rw, valid, 0, 0);
+	}
+}
+
+/*****************************************************************************/
+/* flat display list
+ *
+ * widgets that draw themselves (leaves and containers with a custom
+ * expose_event) in paint order with their position relative to the
+ * toplevel. It is rebuilt after layout (rtoplevel_cache), exposing it
+ * is a linear scan instead of descending through the standard
+ * containers (intersect, save, translate, restore at every level).
+ */
+
+typedef struct {
+	RobWidget *rw;
+	cairo_rectangle_t clip; // visible part, intersected with all parents
+	float x, y;             // widget origin
+} RobDisplayItem;
+
+typedef struct {
+	RobDisplayItem *items;
+	unsigned int    cnt;
+	unsigned int    size;
+	RobWidget     **containers; // standard containers, for rdisplay_list_update()
+	unsigned int    n_containers;
+	unsigned int    c_size;
+	RobWidget      *tl;
+	unsigned int    gen;   // tl->layout_gen when built
+	bool            clean; // no container has to clear its background
+} RobDisplayList;
+
+static void rdisplay_list_free(RobDisplayList *dl) {
+	free(dl->items);
+	free(dl->containers);
+	memset(dl, 0, sizeof(RobDisplayList));
+}
+
+static void rdisplay_list_add(RobDisplayList *dl, RobWidget *rw, const cairo_rectangle_t *clip, const float ox, const float oy) {
+	cairo_rectangle_t a = {rw->trel.x - ox, rw->trel.y - oy, rw->trel.width, rw->trel.height};
+	cairo_rectangle_t c;
+	rect_intersection(&c, &a, clip);
+
+	if (rw->hidden) return;
+
+	if (!rcontainer_is_standard(rw)) {
+		if (dl->cnt == dl->size) {
+			const unsigned int size = dl->size ? dl->size * 2 : 32;
+			RobDisplayItem *items = (RobDisplayItem*) realloc(dl->items, size * sizeof(RobDisplayItem));
+			if (!items) return;
+			dl->items = items;
+			dl->size = size;
 		}
-		rtoplevel_cache(c, valid);
+		RobDisplayItem *it = &dl->items[dl->cnt++];
+		it->rw = rw;
+		it->clip = c;
+		it->x = a.x;
+		it->y = a.y;
+		return;
+	}
+
+	if (dl->n_containers == dl->c_size) {
+		const unsigned int size = dl->c_size ? dl->c_size * 2 : 16;
+		RobWidget **containers = (RobWidget**) realloc(dl->containers, size * sizeof(RobWidget*));
+		if (!containers) return;
+		dl->containers = containers;
+		dl->c_size = size;
+	}
+	dl->containers[dl->n_containers++] = rw;
+
+	for (unsigned int i=0; i < rw->childcount; ++i) {
+		rdisplay_list_add(dl, rw->children[i], &c, ox, oy);
+	}
+}
+
+/* call after rtoplevel_cache(). Hidden widgets are skipped, show
+ * and hide change tl->layout_gen which retires the list until the
+ * next build */
+static void rdisplay_list_build(RobDisplayList *dl, RobWidget *tl) {
+	dl->cnt = 0;
+	dl->n_containers = 0;
+	dl->tl = tl;
+	dl->gen = tl->layout_gen;
+	dl->clean = false; // rtoplevel_cache() flagged all containers 'resized'
+	const cairo_rectangle_t clip = {0, 0, tl->trel.width, tl->trel.height};
+	rdisplay_list_add(dl, tl, &clip, tl->trel.x, tl->trel.y);
+}
+
+/* containers clear their background once after a (re)layout,
+ * this is only done by the recursive expose */
+static bool rdisplay_list_usable(const RobDisplayList *dl) {
+	return dl->cnt > 0 && dl->clean && dl->gen == dl->tl->layout_gen;
+}
+
+/* call after a recursive expose, until the list is clean */
+static void rdisplay_list_update(RobDisplayList *dl) {
+	if (dl->clean || dl->cnt == 0 || dl->gen != dl->tl->layout_gen) return;
+	for (unsigned int i=0; i < dl->n_containers; ++i) {
+		if (dl->containers[i]->resized) return;
+	}
+	for (unsigned int i=0; i < dl->cnt; ++i) {
+		if (dl->items[i].rw->resized) return;
+	}
+	dl->clean = true;
+}
+
+/* ev is relative to the toplevel */
+static void rdisplay_list_expose(const RobDisplayList *dl, cairo_t* cr, const cairo_rectangle_t *ev) {
+	for (unsigned int i=0; i < dl->cnt; ++i) {
+		const RobDisplayItem *it = &dl->items[i];
+		if (!rect_intersect(&it->clip, ev)) continue;
+
+		cairo_rectangle_t event;
+		rect_intersection(&event, &it->clip, ev);
+		event.x -= it->x;
+		event.y -= it->y;
+
+		cairo_save(cr);
+		cairo_translate(cr, it->x, it->y);
+		robwidget_expose(it->rw, cr, &event);
+		cairo_restore(cr);
 	}
-	robwidget_position_cache(rw);
-	rw->cached_position = valid;
 }
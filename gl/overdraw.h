@@ -0,0 +1,114 @@
+/* robtk LV2 GUI
+ *
+ * Copyright 2013 Robin Gareus <robin@gareus.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/* DEBUG_OVERDRAW
+ *
+ * counts how often every canvas pixel is painted during a frame:
+ * widget exposes and container background clears add their (clipped)
+ * area. After each frame the number of painted pixels, the mean and
+ * the maximum paint count are printed to stderr.
+ */
+
+#ifdef DEBUG_OVERDRAW
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef struct {
+	uint8_t *cnt; // per device pixel
+	int width;
+	int height;
+} RtkOverdraw;
+
+/* counter of the frame being drawn, GUI thread */
+static __thread RtkOverdraw *rtk_overdraw = NULL;
+
+static void rtk_overdraw_free(RtkOverdraw *o) {
+	free(o->cnt);
+	o->cnt = NULL;
+	o->width = o->height = 0;
+}
+
+static void rtk_overdraw_alloc(RtkOverdraw *o, int width, int height) {
+	rtk_overdraw_free(o);
+	o->cnt = (uint8_t*) calloc(width * height, sizeof(uint8_t));
+	if (o->cnt) {
+		o->width = width;
+		o->height = height;
+	}
+}
+
+/* add delta to the paint count of the given rectangle
+ * (user coordinates of cr), clipped to the current clip */
+static void rtk_overdraw_add(cairo_t *cr, double x, double y, double w, double h, int delta) {
+	RtkOverdraw *o = rtk_overdraw;
+	if (!o || !o->cnt) return;
+
+	double cx0, cy0, cx1, cy1;
+	cairo_clip_extents(cr, &cx0, &cy0, &cx1, &cy1);
+	double x0 = MAX(x, cx0);
+	double y0 = MAX(y, cy0);
+	double x1 = MIN(x + w, cx1);
+	double y1 = MIN(y + h, cy1);
+	if (x1 <= x0 || y1 <= y0) return;
+
+	cairo_user_to_device(cr, &x0, &y0);
+	cairo_user_to_device(cr, &x1, &y1);
+	const int px0 = MAX(0, (int) floor(x0));
+	const int py0 = MAX(0, (int) floor(y0));
+	const int px1 = MIN(o->width,  (int) ceil(x1));
+	const int py1 = MIN(o->height, (int) ceil(y1));
+
+	for (int py = py0; py < py1; ++py) {
+		uint8_t *row = &o->cnt[py * o->width];
+		for (int px = px0; px < px1; ++px) {
+			const int c = row[px] + delta;
+			row[px] = c < 0 ? 0 : (c > 255 ? 255 : c);
+		}
+	}
+}
+
+/* print and reset the counters */
+static void rtk_overdraw_report(RtkOverdraw *o) {
+	if (!o->cnt) return;
+	uint64_t painted = 0;
+	uint64_t total = 0;
+	uint64_t twice = 0;
+	int max = 0;
+	const size_t n = (size_t) o->width * o->height;
+	for (size_t i = 0; i < n; ++i) {
+		const int c = o->cnt[i];
+		if (c == 0) continue;
+		++painted;
+		total += c;
+		if (c > 1) ++twice;
+		if (c > max) max = c;
+	}
+	if (painted > 0) {
+		fprintf(stderr, "overdraw: %llu px painted, %.2f paints/px, %.1f%% more than once, max %d\n",
+				(unsigned long long) painted, total / (double) painted,
+				100. * twice / (double) painted, max);
+		memset(o->cnt, 0, n);
+	}
+}
+
+#endif
@@ -0,0 +1,151 @@
+/* robwidget - GL expose profiler
+ *
+ * Copyright (C) 2013 Robin Gareus <robin@gareus.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/* all expose_event calls go through robwidget_expose()
+ * (robwidget_expose_event() for retained widgets)
+ *
+ * with PROFILE_EXPOSE every call is timed per widget, the summary
+ * (calls, mean/p99 time, time excl. children, redraw rate, area)
+ * is printed to stderr by rtk_profile_dump().
+ *
+ * PROFILE_HEATMAP additionally paints every redrawn leaf-widget
+ * with a color indicating its redraw rate: blue (rare) .. red (>= 50Hz).
+ */
+
+#ifndef PROFILE_EXPOSE
+
+#define robwidget_expose(RW, CR, EV) robwidget_expose_event(RW, CR, EV)
+
+#else
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define RTK_PROFILE_SAMPLES 256 // recent samples kept for percentiles
+#define RTK_PROFILE_HOT_RATE 50.f // [Hz] heatmap: red
+
+typedef struct {
+	uint64_t calls;
+	uint64_t total_ns;  // incl. child widgets
+	uint64_t self_ns;   // excl. child widgets
+	double   area;      // exposed pixels
+	uint64_t last_ns;   // time of last expose
+	float    rate;      // exposes per second, decaying average
+	uint32_t sample[RTK_PROFILE_SAMPLES]; // [ns]
+} RtkProfile;
+
+/* time spent in nested exposes of the current call */
+static __thread uint64_t rtk_profile_child_ns = 0;
+
+static uint64_t rtk_profile_now() {
+	struct timespec ts;
+	rtk_clock_gettime(&ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#ifdef PROFILE_HEATMAP
+static void rtk_profile_heat(RtkProfile *p, cairo_t *cr, const cairo_rectangle_t *a) {
+	const float h = p->rate > RTK_PROFILE_HOT_RATE ? 1.f : p->rate / RTK_PROFILE_HOT_RATE;
+	cairo_save(cr);
+	cairo_rectangle(cr, a->x, a->y, a->width, a->height);
+	cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+	cairo_set_source_rgba(cr, h, .2, 1.f - h, .15 + .4 * h);
+	cairo_fill(cr);
+	cairo_restore(cr);
+}
+#endif
+
+static bool robwidget_expose(RobWidget *rw, cairo_t *cr, cairo_rectangle_t *ev) {
+	RtkProfile *p = (RtkProfile*) rw->profile;
+	if (!p) {
+		p = (RtkProfile*) calloc(1, sizeof(RtkProfile));
+		if (!p) return robwidget_expose_event(rw, cr, ev);
+		rw->profile = p;
+	}
+	cairo_rectangle_t a;
+	memcpy(&a, ev, sizeof(cairo_rectangle_t)); // expose_event may modify ev
+
+	const uint64_t outer_child_ns = rtk_profile_child_ns;
+	rtk_profile_child_ns = 0;
+
+	const uint64_t t0 = rtk_profile_now();
+	const bool rv = robwidget_expose_event(rw, cr, ev);
+	const uint64_t t1 = rtk_profile_now();
+	const uint64_t dt = t1 - t0;
+
+	p->self_ns += dt > rtk_profile_child_ns ? dt - rtk_profile_child_ns : 0;
+	rtk_profile_child_ns = outer_child_ns + dt;
+
+	p->total_ns += dt;
+	p->area += a.width * a.height;
+	p->sample[p->calls % RTK_PROFILE_SAMPLES] = dt > 0xffffffff ? 0xffffffff : dt;
+	++p->calls;
+
+	/* decaying event count, 1 sec time-constant: approaches the rate in Hz */
+	if (p->last_ns > 0) {
+		p->rate = p->rate * expf((t0 - p->last_ns) * -1e-9f) + 1.f;
+	}
+	p->last_ns = t0;
+
+#ifdef PROFILE_HEATMAP
+	if (rw->childcount == 0) {
+		rtk_profile_heat(p, cr, &a);
+	}
+#endif
+	return rv;
+}
+
+static int rtk_profile_cmp(const void *a, const void *b) {
+	const uint32_t x = *(const uint32_t*)a;
+	const uint32_t y = *(const uint32_t*)b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static void rtk_profile_dump_widget(RobWidget *rw, int depth) {
+	RtkProfile *p = (RtkProfile*) rw->profile;
+	if (p && p->calls > 0) {
+		uint32_t s[RTK_PROFILE_SAMPLES];
+		const int n = p->calls < RTK_PROFILE_SAMPLES ? p->calls : RTK_PROFILE_SAMPLES;
+		memcpy(s, p->sample, n * sizeof(uint32_t));
+		qsort(s, n, sizeof(uint32_t), rtk_profile_cmp);
+		const int p99 = ceilf(n * .99f) - 1;
+
+		fprintf(stderr, "%*s%-*s %8llu %9.1f %9.1f %9.1f %7.1f %12.0f\n",
+				depth, "", 24 - depth, ROBWIDGET_NAME(rw),
+				(unsigned long long) p->calls,
+				p->total_ns / (1000. * p->calls),
+				s[p99 > 0 ? p99 : 0] / 1000.,
+				p->self_ns / (1000. * p->calls),
+				p->rate,
+				p->area / p->calls);
+	}
+	for (unsigned int i = 0; i < rw->childcount; ++i) {
+		rtk_profile_dump_widget(rw->children[i], depth + 1);
+	}
+}
+
+static void rtk_profile_dump(RobWidget *tl) {
+	if (!tl) return;
+	fprintf(stderr, "%-24s %8s %9s %9s %9s %7s %12s\n",
+			"widget", "calls", "mean[us]", "p99[us]", "self[us]", "rate", "area[px]");
+	rtk_profile_dump_widget(tl, 0);
+}
+
+#endif
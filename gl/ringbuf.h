@@ -0,0 +1,124 @@
+/* robtk LV2 GUI
+ *
+ * Copyright 2013 Robin Gareus <robin@gareus.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/* lock-free ringbuffer of fixed-size elements
+ *
+ * capacity is a power of two, positions are free-running
+ * 32bit counters masked on access.
+ *
+ * multi-producer, single consumer (MPSC) using per-slot sequence
+ * numbers. Producers copy elements in with rtk_ring_push(), the
+ * consumer processes them in place: rtk_ring_peek() .. rtk_ring_commit().
+ *
+ * gl/ringbuf_bench.c compares it with the previous posringbuf.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RTK_RING_CACHELINE 64
+
+typedef struct {
+	uint8_t  *d;
+	uint32_t *seq;   // per slot
+	size_t    stride; // element size
+	uint32_t  mask;  // capacity - 1
+	char      _pad0[RTK_RING_CACHELINE];
+	uint32_t  head;  // write position, producer(s)
+	char      _pad1[RTK_RING_CACHELINE];
+	uint32_t  tail;  // read position, consumer
+	char      _pad2[RTK_RING_CACHELINE];
+} RtkRing;
+
+static RtkRing * rtk_ring_alloc(size_t stride, uint32_t min_count) {
+	uint32_t n = 1;
+	while (n < min_count) n <<= 1;
+
+	RtkRing *rb = (RtkRing*) calloc(1, sizeof(RtkRing));
+	if (!rb) return NULL;
+	rb->d = (uint8_t*) malloc(n * stride);
+	rb->seq = (uint32_t*) malloc(n * sizeof(uint32_t));
+	if (!rb->d || !rb->seq) {
+		free(rb->d);
+		free(rb->seq);
+		free(rb);
+		return NULL;
+	}
+	for (uint32_t i = 0; i < n; ++i) {
+		rb->seq[i] = i;
+	}
+	rb->stride = stride;
+	rb->mask = n - 1;
+	return rb;
+}
+
+static void rtk_ring_free(RtkRing *rb) {
+	if (!rb) return;
+	free(rb->seq);
+	free(rb->d);
+	free(rb);
+}
+
+static uint32_t rtk_ring_capacity(const RtkRing *rb) {
+	return rb->mask + 1;
+}
+
+/* elements queued, this includes slots which
+ * are claimed but not yet completely written */
+static uint32_t rtk_ring_read_space(RtkRing *rb) {
+	return __atomic_load_n(&rb->head, __ATOMIC_ACQUIRE) - rb->tail;
+}
+
+/* producer, any thread, returns false if the ring is full */
+static bool rtk_ring_push(RtkRing *rb, const void *elem) {
+	uint32_t pos = __atomic_load_n(&rb->head, __ATOMIC_RELAXED);
+	for (;;) {
+		const int32_t diff = (int32_t)(__atomic_load_n(&rb->seq[pos & rb->mask], __ATOMIC_ACQUIRE) - pos);
+		if (diff == 0) {
+			if (__atomic_compare_exchange_n(&rb->head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				break;
+			}
+		} else if (diff < 0) {
+			return false;
+		} else {
+			pos = __atomic_load_n(&rb->head, __ATOMIC_RELAXED);
+		}
+	}
+	memcpy(&rb->d[(pos & rb->mask) * rb->stride], elem, rb->stride);
+	__atomic_store_n(&rb->seq[pos & rb->mask], pos + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+/* consumer: oldest element or NULL if empty.
+ * The element remains valid until rtk_ring_commit() */
+static void * rtk_ring_peek(RtkRing *rb) {
+	const uint32_t pos = rb->tail;
+	if (__atomic_load_n(&rb->seq[pos & rb->mask], __ATOMIC_ACQUIRE) != pos + 1) {
+		return NULL;
+	}
+	return &rb->d[(pos & rb->mask) * rb->stride];
+}
+
+/* consumer: release the element returned by rtk_ring_peek() */
+static void rtk_ring_commit(RtkRing *rb) {
+	const uint32_t pos = rb->tail;
+	__atomic_store_n(&rb->seq[pos & rb->mask], pos + rb->mask + 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&rb->tail, pos + 1, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,247 @@
+/* robtk LV2 GUI - ringbuffer micro-benchmark
+ *
+ * Copyright 2013 Robin Gareus <robin@gareus.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/* compares gl/ringbuf.h (RtkRing) with the posringbuf it replaced:
+ *  - throughput: one producer thread, one consumer thread [ns/element]
+ *  - latency: a single element handed from producer to consumer [ns]
+ *  - RtkRing throughput with several producers (posringbuf is SPSC only)
+ *
+ *   make -f robtk.mk ringbuf_bench && ./ringbuf_bench
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "ringbuf.h"
+
+#define N_ELEM    (1 << 22) // elements per throughput run
+#define N_LAT     (1 << 16) // latency samples
+#define RB_COUNT  1024      // ring capacity [elements]
+#define MAX_PROD  4
+
+/* busy-wait step, yields now and then to not starve the other
+ * thread on a single CPU. The compiler barrier forces the plain
+ * posringbuf indices to be re-read */
+static inline void relax(int *spin) {
+	__asm__ __volatile__("" ::: "memory");
+	if (++*spin >= 256) {
+		*spin = 0;
+		sched_yield();
+	}
+}
+
+typedef struct {
+	double x, y, w, h; // like cairo_rectangle_t
+} Elem;
+
+/*****************************************************************************
+ * previous implementation, gl/posringbuf.h
+ */
+
+typedef struct {
+	uint8_t *d;
+	size_t rp;
+	size_t wp;
+	size_t len;
+} posringbuf;
+
+static posringbuf * posrb_alloc(size_t siz) {
+	posringbuf *rb  = (posringbuf*) malloc(sizeof(posringbuf));
+	rb->d = (uint8_t*) malloc(siz * sizeof(uint8_t));
+	rb->len = siz;
+	rb->rp = 0;
+	rb->wp = 0;
+	return rb;
+}
+
+static void posrb_free(posringbuf *rb) {
+	free(rb->d);
+	free(rb);
+}
+
+static size_t posrb_write_space(posringbuf *rb) {
+	if (rb->rp == rb->wp) return (rb->len -1);
+	return ((rb->len + rb->rp - rb->wp) % rb->len) -1;
+}
+
+static size_t posrb_read_space(posringbuf *rb) {
+	return ((rb->len + rb->wp - rb->rp) % rb->len);
+}
+
+static int posrb_read(posringbuf *rb, uint8_t *d, size_t len) {
+	if (posrb_read_space(rb) < len) return -1;
+	if (rb->rp + len <= rb->len) {
+		memcpy((void*) d, (void*) &rb->d[rb->rp], len * sizeof (uint8_t));
+	} else {
+		int part = rb->len - rb->rp;
+		int remn = len - part;
+		memcpy((void*) d, (void*) &(rb->d[rb->rp]), part * sizeof (uint8_t));
+		memcpy((void*) &(d[part]), (void*) rb->d, remn * sizeof (uint8_t));
+	}
+	rb->rp = (rb->rp + len) % rb->len;
+	return 0;
+}
+
+static int posrb_write(posringbuf *rb, uint8_t *d, size_t len) {
+	if (posrb_write_space(rb) < len) return -1;
+	if (rb->wp + len <= rb->len) {
+		memcpy((void*) &rb->d[rb->wp], (void*) d, len * sizeof(uint8_t));
+	} else {
+		int part = rb->len - rb->wp;
+		int remn = len - part;
+		memcpy((void*) &rb->d[rb->wp], (void*) d, part * sizeof(uint8_t));
+		memcpy((void*) rb->d, (void*) &d[part], remn * sizeof(uint8_t));
+	}
+	rb->wp = (rb->wp + len) % rb->len;
+	return 0;
+}
+
+/*****************************************************************************/
+
+static uint64_t now_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+	const uint64_t x = *(const uint64_t*)a;
+	const uint64_t y = *(const uint64_t*)b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+typedef struct {
+	posringbuf *prb;
+	RtkRing    *rb;
+	int         count;  // elements to produce
+	bool        pingpong; // wait until consumed before the next push
+} Job;
+
+static void* pos_producer(void *arg) {
+	Job *j = (Job*) arg;
+	Elem e = {0, 0, 0, 0};
+	int spin = 0;
+	for (int i = 0; i < j->count; ++i) {
+		e.x = i;
+		if (j->pingpong) {
+			while (posrb_read_space(j->prb) > 0) relax(&spin);
+			e.w = now_ns();
+		}
+		while (posrb_write(j->prb, (uint8_t*) &e, sizeof(Elem))) relax(&spin);
+	}
+	return NULL;
+}
+
+static void* rtk_producer(void *arg) {
+	Job *j = (Job*) arg;
+	Elem e = {0, 0, 0, 0};
+	int spin = 0;
+	for (int i = 0; i < j->count; ++i) {
+		e.x = i;
+		if (j->pingpong) {
+			while (rtk_ring_read_space(j->rb) > 0) relax(&spin);
+			e.w = now_ns();
+		}
+		while (!rtk_ring_push(j->rb, &e)) relax(&spin);
+	}
+	return NULL;
+}
+
+/* returns ns per element; with 'lat' the hand-off latency of each element */
+static double run_pos(int count, uint64_t *lat) {
+	Job j = { posrb_alloc(RB_COUNT * sizeof(Elem)), NULL, count, lat != NULL };
+	pthread_t t;
+	const uint64_t t0 = now_ns();
+	pthread_create(&t, NULL, pos_producer, &j);
+	Elem e;
+	int spin = 0;
+	for (int i = 0; i < count; ++i) {
+		/* copy out, as cairo_expose() did */
+		while (posrb_read(j.prb, (uint8_t*) &e, sizeof(Elem))) relax(&spin);
+		if (lat) lat[i] = now_ns() - (uint64_t) e.w;
+	}
+	const uint64_t t1 = now_ns();
+	pthread_join(t, NULL);
+	posrb_free(j.prb);
+	return (t1 - t0) / (double) count;
+}
+
+static double run_rtk(int count, int n_prod, uint64_t *lat) {
+	Job j = { NULL, rtk_ring_alloc(sizeof(Elem), RB_COUNT), count / n_prod, lat != NULL };
+	pthread_t t[MAX_PROD];
+	const uint64_t t0 = now_ns();
+	for (int p = 0; p < n_prod; ++p) {
+		pthread_create(&t[p], NULL, rtk_producer, &j);
+	}
+	const int total = j.count * n_prod;
+	int spin = 0;
+	for (int i = 0; i < total; ++i) {
+		/* process in place */
+		const Elem *e;
+		while (!(e = (const Elem*) rtk_ring_peek(j.rb))) relax(&spin);
+		if (lat) lat[i] = now_ns() - (uint64_t) e->w;
+		rtk_ring_commit(j.rb);
+	}
+	const uint64_t t1 = now_ns();
+	for (int p = 0; p < n_prod; ++p) {
+		pthread_join(t[p], NULL);
+	}
+	rtk_ring_free(j.rb);
+	return (t1 - t0) / (double) total;
+}
+
+static void print_latency(const char *name, uint64_t *lat, int n) {
+	qsort(lat, n, sizeof(uint64_t), cmp_u64);
+	uint64_t sum = 0;
+	for (int i = 0; i < n; ++i) sum += lat[i];
+	printf("%-24s latency    mean %7.1f ns  p50 %6llu ns  p99 %6llu ns\n", name,
+			sum / (double) n,
+			(unsigned long long) lat[n / 2],
+			(unsigned long long) lat[n * 99 / 100]);
+}
+
+int main(int argc, char **argv) {
+	uint64_t *lat = (uint64_t*) malloc(N_LAT * sizeof(uint64_t));
+	if (!lat) return 1;
+
+	printf("element size %zu bytes, capacity %d elements\n", sizeof(Elem), RB_COUNT);
+
+	printf("%-24s throughput %7.1f ns/element\n", "posringbuf", run_pos(N_ELEM, NULL));
+	printf("%-24s throughput %7.1f ns/element\n", "RtkRing", run_rtk(N_ELEM, 1, NULL));
+	for (int p = 2; p <= MAX_PROD; p *= 2) {
+		char name[32];
+		snprintf(name, sizeof(name), "RtkRing %d producers", p);
+		printf("%-24s throughput %7.1f ns/element\n", name, run_rtk(N_ELEM, p, NULL));
+	}
+
+	run_pos(N_LAT, lat);
+	print_latency("posringbuf", lat, N_LAT);
+	run_rtk(N_LAT, 1, lat);
+	print_latency("RtkRing", lat, N_LAT);
+
+	free(lat);
+	return 0;
+}
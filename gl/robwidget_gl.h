@@ -20,8 +20,8 @@
 #define GET_HANDLE(HDL) (((RobWidget*)HDL)->self)
 
 #define robwidget_set_expose_event(RW, EVT)    { (RW)->expose_event = EVT; }
-#define robwidget_set_size_request(RW, EVT)    { (RW)->size_request = EVT; }
-#define robwidget_set_size_allocate(RW, EVT)   { (RW)->size_allocate = EVT; }
+#define robwidget_set_size_request(RW, EVT)    { (RW)->size_request = EVT; robwidget_size_changed(RW); }
+#define robwidget_set_size_allocate(RW, EVT)   { (RW)->size_allocate = EVT; robwidget_size_changed(RW); }
 #define robwidget_set_size_limit(RW, EVT)      { (RW)->size_limit = EVT; }
 #define robwidget_set_size_default(RW, EVT)    { (RW)->size_default = EVT; }
 #define robwidget_set_mouseup(RW, EVT)         { (RW)->mouseup = EVT; }
@@ -58,6 +58,9 @@ static void offset_traverse_from_child(RobWidget *rw, RobTkBtnEvent *ev) {
 }
 
 static RobWidget * robwidget_child_at(RobWidget *rw, int x, int y) {
+	if (rw->hit_index) {
+		return rtk_hit_index_find(rw, x, y);
+	}
 	for (unsigned int i=0; i < rw->childcount; ++i) {
 		RobWidget * c = (RobWidget *) rw->children[i];
 		if (c->hidden) continue;
@@ -74,15 +77,9 @@ static RobWidget * robwidget_child_at(RobWidget *rw, int x, int y) {
 static RobWidget* decend_into_widget_tree(RobWidget *rw, int x, int y) {
 	if (rw->childcount == 0) return rw;
 	x-=rw->area.x; y-=rw->area.y;
-	for (unsigned int i=0; i < rw->childcount; ++i) {
-		RobWidget * c = (RobWidget *) rw->children[i];
-		if (c->hidden) continue;
-		if (x >= c->area.x && y >= c->area.y
-				&& x <= c->area.x + c->area.width
-				&& y <= c->area.y + c->area.height
-			 ) {
-			return decend_into_widget_tree(c, x, y);
-		}
+	RobWidget * c = robwidget_child_at(rw, x, y);
+	if (c) {
+		return decend_into_widget_tree(c, x, y);
 	}
 	return NULL;
 }
@@ -93,6 +90,14 @@ static RobWidget* decend_into_widget_tree(RobWidget *rw, int x, int y) {
 /*declared in packer.h */
 static void rtoplevel_size_request(RobWidget* rw, int *w, int *h);
 static bool rcontainer_expose_event(RobWidget* rw, cairo_t* cr, cairo_rectangle_t *ev);
+static bool rcontainer_expose_event_no_clear(RobWidget* rw, cairo_t* cr, cairo_rectangle_t *ev);
+
+/* container which only exposes its children */
+static bool rcontainer_is_standard(RobWidget *rw) {
+	return rw->childcount > 0
+		&& (rw->expose_event == rcontainer_expose_event
+		    || rw->expose_event == rcontainer_expose_event_no_clear);
+}
 
 static RobWidget * robwidget_new(void *handle) {
 	RobWidget * rw = (RobWidget *) calloc(1, sizeof(RobWidget));
@@ -103,9 +108,17 @@ static RobWidget * robwidget_new(void *handle) {
 	return rw;
 }
 
+/* set the toplevel handle of a subtree, when it is (re)attached */
+static void robwidget_set_top(RobWidget *rw, void * const top) {
+	rw->top = top;
+	for (unsigned int i=0; i < rw->childcount; ++i) {
+		robwidget_set_top(rw->children[i], top);
+	}
+}
+
 static void robwidget_make_toplevel(RobWidget *rw, void * const handle) {
-	rw->top = handle;
 	rw->parent = rw;
+	robwidget_set_top(rw, handle);
 }
 
 static void robwidget_destroy(RobWidget *rw) {
@@ -127,6 +140,13 @@ static void robwidget_destroy(RobWidget *rw) {
 #endif
 
 	free(rw->children);
+	if (rw->cache) {
+		cairo_surface_destroy(rw->cache);
+	}
+#ifdef PROFILE_EXPOSE
+	free(rw->profile);
+#endif
+	rtk_hit_index_free(rw);
 #if 0
 	rw->children = NULL;
 	rw->childcount = 0;
@@ -134,6 +154,86 @@ static void robwidget_destroy(RobWidget *rw) {
 	free(rw);
 }
 
+/* size negotiation: requests and allocations are recorded,
+ * a later size change can then be re-laid out starting
+ * at the innermost container whose size does not change.
+ *
+ * Requests are memoized until robwidget_size_changed(), an
+ * allocation with the same size as before is skipped: layouts
+ * of unchanged subtrees are O(1).
+ */
+
+#ifdef DEBUG_RESIZE
+static unsigned int robwidget_size_request_calls = 0; // memo misses
+#endif
+
+/* the widget's size request may have changed (text, marks, ..),
+ * drop the memoized requests of the widget and its parents */
+static void robwidget_size_changed(RobWidget *rw) {
+	for (; rw; rw = rw->parent) {
+		rw->req_valid = false;
+		if (rw->parent == rw) break;
+	}
+}
+
+/* drop the memoized requests of the whole subtree, for plugin
+ * callbacks which change the geometry of many widgets at once
+ * (size_limit, size_default) */
+static void robwidget_size_reset(RobWidget *rw) {
+	rw->req_valid = false;
+	for (unsigned int i=0; i < rw->childcount; ++i) {
+		robwidget_size_reset(rw->children[i]);
+	}
+}
+
+static void robwidget_size_request(RobWidget *rw, int *w, int *h) {
+	if (rw->req_valid) {
+		*w = rw->req_w;
+		*h = rw->req_h;
+		return;
+	}
+#ifdef DEBUG_RESIZE
+	++robwidget_size_request_calls;
+#endif
+	rw->size_request(rw, w, h);
+	rw->req_w = *w;
+	rw->req_h = *h;
+	rw->req_valid = true;
+	rw->allocated = false;
+}
+
+static void robwidget_size_allocate(RobWidget *rw, int w, int h) {
+	if (rw->allocated && rw->req_valid && w == rw->alloc_w && h == rw->alloc_h) {
+		rw->area.width  = rw->alloc_area_w;
+		rw->area.height = rw->alloc_area_h;
+		return;
+	}
+	if (rw->allocated) {
+		/* size_allocate() expects the state left by size_request()
+		 * (the request in 'area', for containers also in the children's) */
+		int rw_, rh_;
+		rw->size_request(rw, &rw_, &rh_);
+	}
+	rw->size_allocate(rw, w, h);
+	rw->alloc_w = w;
+	rw->alloc_h = h;
+	rw->alloc_area_w = rw->area.width;
+	rw->alloc_area_h = rw->area.height;
+	rw->alloc_valid = true;
+	rw->allocated = true;
+}
+
+/* structural change (show, hide, packing, alignment):
+ * the next layout has to start at the toplevel */
+static void robwidget_layout_invalidate(RobWidget *rw) {
+	robwidget_size_changed(rw);
+	while (rw->parent && rw->parent != rw) {
+		rw = rw->parent;
+	}
+	rw->alloc_valid = false;
+	++rw->layout_gen;
+}
+
 static void robwidget_set_size(RobWidget *rw, int w, int h) {
 	rw->area.width  = w;
 	rw->area.height = h;
@@ -149,6 +249,7 @@ static void robwidget_set_area(RobWidget *rw, int x, int y, int w, int h) {
 static void robwidget_set_alignment(RobWidget *rw, float xalign, float yalign) {
 	rw->xalign = xalign;
 	rw->yalign = yalign;
+	robwidget_layout_invalidate(rw);
 }
 
 static void robwidget_resize_toplevel(RobWidget *rw, int w, int h) {
@@ -159,6 +260,7 @@ static void robwidget_show(RobWidget *rw, bool resize_window) {
 	// XXX never call from expose_event
 	if (rw->hidden) {
 		rw->hidden = FALSE;
+		robwidget_layout_invalidate(rw);
 		if (resize_window) resize_self(rw);
 	}
 }
@@ -167,21 +269,140 @@ static void robwidget_hide(RobWidget *rw, bool resize_window) {
 	// XXX never call from expose_event
 	if (!rw->hidden) {
 		rw->hidden = TRUE;
+		robwidget_layout_invalidate(rw);
 		if (resize_window) resize_self(rw);
 	}
 }
 
+/* the widget's expose_event fills its complete area with opaque
+ * colors: parent containers skip clearing the background behind it */
+static void robwidget_set_opaque(RobWidget *rw, bool opaque) {
+	rw->opaque = opaque;
+}
+
+/* widget and all its parents are shown */
+static bool robwidget_is_visible(RobWidget *rw) {
+	for (;;) {
+		if (rw->hidden) return false;
+		if (!rw->parent || rw->parent == rw) return true;
+		rw = rw->parent;
+	}
+}
+
 /*****************************************************************************/
-/* host helper */
+/* retained mode
+ *
+ * opt-in for leaf widgets: the widget is rendered into its own surface
+ * only after it was invalidated (queue_draw*) or resized, exposes
+ * composite the cached surface.
+ */
 
-static void const * robwidget_get_toplevel_handle(RobWidget *rw) {
-	void const *h = NULL;
-	while (rw) {
-		if (rw == rw->parent) {
-			h = rw->top;
-			break;
+static void robwidget_set_retained(RobWidget *rw, bool retained) {
+	rw->retained = retained;
+	rw->cache_dirty = true;
+	if (!retained && !rw->layer && rw->cache) {
+		cairo_surface_destroy(rw->cache);
+		rw->cache = NULL;
+	}
+}
+
+/* layer mode (openGL only)
+ *
+ * for frequently updated leaf widgets (meters, plots): the widget
+ * is rendered into its own texture and composited by the GPU on top
+ * of the rest of the UI. Redrawing it does not touch the canvas.
+ * Without openGL (PUGL_XSHM) the widget is drawn as usual.
+ * The set of layers is re-collected before the next frame after
+ * a layout and when the flag changes, the canvas below the widget
+ * is cleared then. Call from the GUI thread.
+ */
+static void queue_layers_rebuild(RobWidget *rw); // ui_gl.c
+
+static void robwidget_set_layer(RobWidget *rw, bool hot) {
+	const bool changed = rw->layer != hot;
+	rw->layer = hot;
+	rw->cache_dirty = true;
+	if (changed) {
+		queue_layers_rebuild(rw);
+	}
+	if (!hot && !rw->retained && rw->cache) {
+		cairo_surface_destroy(rw->cache);
+		rw->cache = NULL;
+	}
+}
+
+/* may be called from any thread */
+static void robwidget_invalidate(RobWidget *rw) {
+	if (rw->retained || rw->layer) {
+		__atomic_store_n(&rw->cache_dirty, true, __ATOMIC_RELEASE);
+	}
+}
+
+/* update the cached surface if needed, returns true if it was re-rendered */
+static bool robwidget_cache_render(RobWidget *rw, const float scale) {
+	const bool dirty = __atomic_exchange_n(&rw->cache_dirty, false, __ATOMIC_ACQ_REL);
+	cairo_t *c = NULL;
+	if (!rw->cache || scale != rw->cache_scale
+			|| rw->cache_w != rw->area.width || rw->cache_h != rw->area.height) {
+		if (rw->cache) {
+			cairo_surface_destroy(rw->cache);
 		}
-		rw = rw->parent;
+		rw->cache_scale = scale;
+		rw->cache_w = rw->area.width;
+		rw->cache_h = rw->area.height;
+		rw->cache = rtk_cache_surface_create(rw->cache_w, rw->cache_h, scale, &c);
+	} else if (dirty) {
+		c = cairo_create(rw->cache);
+		cairo_scale(c, scale, scale);
+		cairo_set_operator(c, CAIRO_OPERATOR_CLEAR);
+		cairo_paint(c);
+		cairo_set_operator(c, CAIRO_OPERATOR_OVER);
 	}
-	return h;
+
+	if (!c) {
+		return false;
+	}
+	cairo_rectangle_t a = {0, 0, rw->cache_w, rw->cache_h};
+	rw->expose_event(rw, c, &a);
+	cairo_destroy(c);
+	cairo_surface_flush(rw->cache);
+	return true;
+}
+
+static bool robwidget_expose_event(RobWidget *rw, cairo_t *cr, cairo_rectangle_t *ev) {
+#ifndef PUGL_XSHM
+	if (rw->layer && rw->childcount == 0) {
+		return TRUE; // composited by the GL backend, see robwidget_set_layer()
+	}
+#endif
+#ifdef DEBUG_OVERDRAW
+	if (!rcontainer_is_standard(rw)) {
+		rtk_overdraw_add(cr, ev->x, ev->y, ev->width, ev->height, 1);
+	}
+#endif
+	if (!rw->retained || rw->childcount > 0) {
+		return rw->expose_event(rw, cr, ev);
+	}
+	if (rw->area.width <= 0 || rw->area.height <= 0) {
+		return TRUE;
+	}
+
+	robwidget_cache_render(rw, rtk_cache_scale(cr));
+
+	cairo_save(cr);
+	cairo_rectangle(cr, ev->x, ev->y, ev->width, ev->height);
+	cairo_clip(cr);
+	cairo_set_operator(cr, rw->opaque ? CAIRO_OPERATOR_SOURCE : CAIRO_OPERATOR_OVER);
+	rtk_set_source_cache(cr, rw->cache, 0, 0, rw->cache_scale);
+	cairo_paint(cr);
+	cairo_restore(cr);
+	return TRUE;
+}
+
+/*****************************************************************************/
+/* host helper */
+
+/* NULL unless rw is attached to a toplevel */
+static void const * robwidget_get_toplevel_handle(RobWidget *rw) {
+	return rw->top;
 }
@@ -0,0 +1,233 @@
+/* robtk LV2 GUI
+ *
+ * Copyright 2013 Robin Gareus <robin@gareus.org>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/* frame-timing and damage statistics
+ *
+ * disabled unless the environment variable ROBTK_STATS is set:
+ *   ROBTK_STATS=1         dump to stderr
+ *   ROBTK_STATS=<file>    append to <file>
+ *
+ * statistics are written as one JSON object per GUI instance
+ * when the GUI is closed and after the process received SIGUSR1
+ * (on the next iteration of the GUI thread).
+ * The signal handler is only installed if the host has none, and
+ * removed again when the last GUI instance is closed.
+ *
+ * values are collected in lock-free log2 histograms:
+ * bin 0 counts zero, bin n counts values in [2^(n-1), 2^n).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <pthread.h>
+
+enum {
+	RTK_STAT_FASTTRACK = 0, // fast-track (queue_tiny_rect) exposes [us]
+	RTK_STAT_EXPOSE,        // toplevel expose_event [us]
+	RTK_STAT_FLUSH,         // cairo_surface_flush [us]
+	RTK_STAT_UPLOAD,        // canvas upload (texture or XShm) [us]
+	RTK_STAT_PRESENT,       // draw and buffer-swap, or XShmPutImage [us]
+	RTK_STAT_FRAME,         // complete display callback [us]
+	RTK_STAT_DAMAGE,        // damaged pixels per frame
+	RTK_STAT_LAST
+};
+
+#define RTK_STAT_BINS 32
+
+static const char * const rtk_stat_names[RTK_STAT_LAST] = {
+	"fasttrack_us",
+	"expose_us",
+	"flush_us",
+	"upload_us",
+	"present_us",
+	"frame_us",
+	"damage_px",
+};
+
+typedef struct {
+	volatile uint64_t bin[RTK_STAT_BINS];
+	volatile uint64_t count;
+	volatile uint64_t sum;
+	volatile uint64_t max;
+} RtkHistogram;
+
+typedef struct {
+	bool         enabled;
+	char        *name;
+	int          dump_gen;
+	RtkHistogram h[RTK_STAT_LAST];
+	volatile uint64_t rb_overflow; // fast-track queue full, fell back to queue_draw_area
+	volatile uint64_t damage_overflow; // damage queue full, fell back to full redraw
+	volatile uint64_t rb_resize; // fast-track queue was grown after overflow
+	uint64_t          rb_capacity; // current fast-track queue size
+} RtkStats;
+
+static volatile sig_atomic_t rtk_stats_signal_gen = 0;
+
+static pthread_mutex_t rtk_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int rtk_stats_instances = 0; // enabled RtkStats
+
+#ifndef _WIN32
+static bool rtk_stats_signal_installed = false;
+static struct sigaction rtk_stats_prev_action;
+
+static void rtk_stats_signal_handler(int sig) {
+	++rtk_stats_signal_gen;
+}
+#endif
+
+static const char *rtk_stats_target() {
+	return getenv("ROBTK_STATS");
+}
+
+static void rtk_stats_init(RtkStats *s, const char *name) {
+	memset(s, 0, sizeof(RtkStats));
+	s->enabled = rtk_stats_target() != NULL;
+	if (!s->enabled) return;
+	s->name = strdup(name ? name : "");
+	pthread_mutex_lock(&rtk_stats_lock);
+#ifndef _WIN32
+	/* don't override the host's handler */
+	if (rtk_stats_instances == 0
+			&& sigaction(SIGUSR1, NULL, &rtk_stats_prev_action) == 0
+			&& !(rtk_stats_prev_action.sa_flags & SA_SIGINFO)
+			&& rtk_stats_prev_action.sa_handler == SIG_DFL) {
+		struct sigaction sa;
+		memset(&sa, 0, sizeof(sa));
+		sa.sa_handler = rtk_stats_signal_handler;
+		sa.sa_flags = SA_RESTART;
+		sigemptyset(&sa.sa_mask);
+		rtk_stats_signal_installed = sigaction(SIGUSR1, &sa, NULL) == 0;
+	}
+#endif
+	++rtk_stats_instances;
+	pthread_mutex_unlock(&rtk_stats_lock);
+	s->dump_gen = rtk_stats_signal_gen;
+}
+
+static uint64_t rtk_stats_time() {
+	struct timespec ts;
+	rtk_clock_gettime(&ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void rtk_stats_add(RtkStats *s, int id, uint64_t val) {
+	if (!s->enabled) return;
+	RtkHistogram *h = &s->h[id];
+	int bin = 0;
+	while (val >> bin && bin < RTK_STAT_BINS - 1) ++bin;
+	__sync_fetch_and_add(&h->bin[bin], 1);
+	__sync_fetch_and_add(&h->count, 1);
+	__sync_fetch_and_add(&h->sum, val);
+	uint64_t max = h->max;
+	while (val > max && !__sync_bool_compare_and_swap(&h->max, max, val)) {
+		max = h->max;
+	}
+}
+
+/* record time elapsed since t0 (from rtk_stats_time) */
+static void rtk_stats_since(RtkStats *s, int id, uint64_t t0) {
+	if (!s->enabled) return;
+	rtk_stats_add(s, id, rtk_stats_time() - t0);
+}
+
+static void rtk_stats_count(RtkStats *s, volatile uint64_t *counter) {
+	if (!s->enabled) return;
+	__sync_fetch_and_add(counter, 1);
+}
+
+static void rtk_stats_dump(RtkStats *s, uint64_t frames_presented, uint64_t frames_skipped) {
+	if (!s->enabled) return;
+	const char *target = rtk_stats_target();
+	FILE *f = stderr;
+	if (target && strcmp(target, "1") && strcmp(target, "") && strcmp(target, "stderr")) {
+		f = fopen(target, "a");
+		if (!f) {
+			fprintf(stderr, "robtk: cannot open stats file '%s'\n", target);
+			return;
+		}
+	}
+
+	fprintf(f, "{\"ui\":\"");
+	for (const char *c = s->name; *c; ++c) {
+		if (*c == '"' || *c == '\\') fputc('\\', f);
+		fputc(*c, f);
+	}
+	fprintf(f, "\",\"frames_presented\":%llu,\"frames_skipped\":%llu"
+			",\"rb_overflow\":%llu,\"rb_resize\":%llu,\"rb_capacity\":%llu,\"damage_overflow\":%llu",
+			(unsigned long long) frames_presented,
+			(unsigned long long) frames_skipped,
+			(unsigned long long) s->rb_overflow,
+			(unsigned long long) s->rb_resize,
+			(unsigned long long) s->rb_capacity,
+			(unsigned long long) s->damage_overflow);
+
+	for (int i = 0; i < RTK_STAT_LAST; ++i) {
+		const RtkHistogram *h = &s->h[i];
+		int last = RTK_STAT_BINS - 1;
+		while (last > 0 && h->bin[last] == 0) --last;
+		fprintf(f, ",\"%s\":{\"count\":%llu,\"sum\":%llu,\"max\":%llu,\"log2_hist\":[",
+				rtk_stat_names[i],
+				(unsigned long long) h->count,
+				(unsigned long long) h->sum,
+				(unsigned long long) h->max);
+		for (int b = 0; b <= last; ++b) {
+			fprintf(f, "%s%llu", b > 0 ? "," : "", (unsigned long long) h->bin[b]);
+		}
+		fprintf(f, "]}");
+	}
+	fprintf(f, "}\n");
+
+	if (f != stderr) {
+		fclose(f);
+	} else {
+		fflush(f);
+	}
+}
+
+/* dump if a signal was received since the last call */
+static void rtk_stats_poll(RtkStats *s, uint64_t frames_presented, uint64_t frames_skipped) {
+	if (!s->enabled) return;
+	const int gen = rtk_stats_signal_gen;
+	if (gen == s->dump_gen) return;
+	s->dump_gen = gen;
+	rtk_stats_dump(s, frames_presented, frames_skipped);
+}
+
+static void rtk_stats_free(RtkStats *s) {
+	if (s->enabled) {
+		pthread_mutex_lock(&rtk_stats_lock);
+		/* the handler must not outlive the .so */
+		if (--rtk_stats_instances == 0) {
+#ifndef _WIN32
+			if (rtk_stats_signal_installed) {
+				sigaction(SIGUSR1, &rtk_stats_prev_action, NULL);
+				rtk_stats_signal_installed = false;
+			}
+#endif
+		}
+		pthread_mutex_unlock(&rtk_stats_lock);
+	}
+	free(s->name);
+	s->name = NULL;
+	s->enabled = false;
+}
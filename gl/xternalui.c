@@ -19,6 +19,7 @@ static void x_run (struct lv2_external_ui * handle) {
 		puglHideWindow(self->view);
 #else
 		self->ui_queue_puglXWindow = -1;
+		ui_wakeup(self);
 #endif
 		self->ui_closed(self->controller);
 	}
@@ -31,6 +32,7 @@ static void x_show (struct lv2_external_ui * handle) {
 	ui_enable(self->ui);
 #else
 	self->ui_queue_puglXWindow = 1;
+	ui_wakeup(self);
 #endif
 }
 
@@ -41,6 +43,7 @@ static void x_hide (struct lv2_external_ui * handle) {
 	puglHideWindow(self->view);
 #else
 	self->ui_queue_puglXWindow = -1;
+	ui_wakeup(self);
 #endif
 }
 #endif
@@ -229,6 +229,12 @@ static void robwidget_resize_toplevel(RobWidget *rw, int w, int h) {
 	}
 }
 
+/* GTK does its own buffering */
+static void robwidget_set_retained(RobWidget *rw, bool retained) { }
+static void robwidget_set_layer(RobWidget *rw, bool hot) { }
+static void robwidget_set_opaque(RobWidget *rw, bool opaque) { }
+static void robwidget_size_changed(RobWidget *rw) { }
+
 static void robwidget_show(RobWidget *rw, bool resize_window) {
 	gtk_widget_show_all(rw->c);
 }
@@ -333,6 +333,95 @@ puglProcessEvents(PuglView* view);
 PUGL_API void
 puglPostRedisplay(PuglView* view);
 
+/**
+   Return true if a redisplay has been requested and not yet performed.
+*/
+PUGL_API bool
+puglIsRedisplayPending(PuglView* view);
+
+/**
+   Return a file descriptor which becomes readable when window-system
+   events arrive, or -1 if this is not supported by the platform.
+
+   This allows to wait for events using poll() or select() rather
+   than calling puglProcessEvents() periodically.
+*/
+PUGL_API int
+puglGetEventFd(PuglView* view);
+
+/**
+   Flush pending requests to the window-system and return true if
+   events are queued which can be processed without waiting.
+
+   This should be called before waiting on puglGetEventFd().
+*/
+PUGL_API bool
+puglHasPendingEvents(PuglView* view);
+
+/**
+   Discard the current frame.
+
+   This may be called from the display function if nothing was drawn.
+   The buffers are not swapped and the window keeps its current content.
+   It is ignored if the redisplay was requested by the window-system.
+*/
+PUGL_API void
+puglSkipFrame(PuglView* view);
+
+/**
+   Return true if the window-system requested the current redisplay
+   (e.g. the window was exposed) and the view needs to be drawn completely.
+
+   This should only be called from the display function.
+*/
+PUGL_API bool
+puglIsExposed(PuglView* view);
+
+/**
+   Swap buffers now, instead of after the display function returns.
+
+   This may be called from the display function, e.g. to time the swap.
+   It has no effect with PUGL_XSHM.
+*/
+PUGL_API void
+puglSwapBuffers(PuglView* view);
+
+#ifdef PUGL_XSHM
+/**
+   Allocate the image used for software rendering (X11 MIT-SHM).
+
+   Any previously allocated image is released. The pixel format is
+   native-endian 32bit xRGB (compatible with CAIRO_FORMAT_ARGB32).
+   @param stride returns the number of bytes per row.
+   @return pointer to the pixel data or NULL on error.
+*/
+PUGL_API unsigned char*
+puglAllocImage(PuglView* view, int width, int height, int* stride);
+
+/**
+   Copy an area of the image to the window.
+
+   @param dest_x horizontal offset of the image in the window.
+   @param dest_y vertical offset of the image in the window.
+*/
+PUGL_API void
+puglPutImage(PuglView* view, int x, int y, int width, int height, int dest_x, int dest_y);
+
+/**
+   Send pending puglPutImage() calls to the server, does not wait.
+*/
+PUGL_API void
+puglFlushImage(PuglView* view);
+
+/**
+   Wait until all pending puglPutImage() calls have completed.
+
+   The image must not be modified before this returns.
+*/
+PUGL_API void
+puglWaitImage(PuglView* view);
+#endif
+
 /**
    Destroy a GL window.
 */
@@ -46,6 +46,9 @@ struct PuglViewImpl {
 	bool     mouse_in_view;
 	bool     ignoreKeyRepeat;
 	bool     redisplay;
+	bool     expose;
+	bool     skip_frame;
+	bool     swapped;
 	bool     user_resizable;
 	bool     set_window_hints;
 	bool     ontop;
@@ -77,9 +80,28 @@ puglGetModifiers(PuglView* view)
 	return view->mods;
 }
 
+void
+puglSkipFrame(PuglView* view)
+{
+	view->skip_frame = true;
+}
+
+bool
+puglIsExposed(PuglView* view)
+{
+	return view->expose;
+}
+
+bool
+puglIsRedisplayPending(PuglView* view)
+{
+	return view->redisplay || view->resize;
+}
+
 static void
 puglDefaultReshape(PuglView* view, int width, int height)
 {
+#ifndef PUGL_XSHM
 	glViewport(0, 0, width, height);
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
@@ -88,6 +110,7 @@ puglDefaultReshape(PuglView* view, int width, int height)
 
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
+#endif
 }
 
 void
@@ -88,9 +88,14 @@ __attribute__ ((visibility ("hidden")))
 static void
 puglDisplay(PuglView* view)
 {
+	view->expose = true; // drawRect, always present
+	view->swapped = false;
 	if (view->displayFunc) {
 		view->displayFunc(view);
 	}
+	if (!view->swapped) {
+		puglSwapBuffers(view);
+	}
 }
 
 __attribute__ ((visibility ("hidden")))
@@ -185,8 +190,6 @@ __attribute__ ((visibility ("hidden")))
 - (void) drawRect:(NSRect)rect
 {
 	puglDisplay(puglview);
-	glFlush();
-	glSwapAPPLE();
 }
 
 static unsigned
@@ -469,8 +472,28 @@ puglPostRedisplay(PuglView* view)
 	//view->redisplay = true; // unused
 }
 
+void
+puglSwapBuffers(PuglView* view)
+{
+	view->swapped = true;
+	glFlush();
+	glSwapAPPLE();
+}
+
 PuglNativeWindow
 puglGetNativeWindow(PuglView* view)
 {
 	return (PuglNativeWindow)view->impl->glview;
 }
+
+int
+puglGetEventFd(PuglView* view)
+{
+	return -1;
+}
+
+bool
+puglHasPendingEvents(PuglView* view)
+{
+	return false;
+}
@@ -179,10 +179,21 @@ puglDisplay(PuglView* view)
 	glLoadIdentity();
 
 	view->redisplay = false;
+	view->expose = true; // WM_PAINT, always present
+	view->swapped = false;
 	if (view->displayFunc) {
 		view->displayFunc(view);
 	}
 
+	if (!view->swapped) {
+		puglSwapBuffers(view);
+	}
+}
+
+void
+puglSwapBuffers(PuglView* view)
+{
+	view->swapped = true;
 	glFlush();
 	SwapBuffers(view->impl->hdc);
 }
@@ -417,3 +428,15 @@ puglGetNativeWindow(PuglView* view)
 {
 	return (PuglNativeWindow)view->impl->hwnd;
 }
+
+int
+puglGetEventFd(PuglView* view)
+{
+	return -1;
+}
+
+bool
+puglHasPendingEvents(PuglView* view)
+{
+	return false;
+}
@@ -24,8 +24,15 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef PUGL_XSHM
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#else
 #include <GL/gl.h>
 #include <GL/glx.h>
+#endif
 #include <X11/Xatom.h>
 #include <X11/Xlib.h>
 #include <X11/keysym.h>
@@ -42,14 +49,36 @@
  */
 //#define VERBOSE_PUGL
 
+/* PUGL_XSHM: software rendering, no openGL.
+ * The application draws into an image (puglAllocImage) which is
+ * copied to the window with XShmPutImage (puglPutImage).
+ * The server reports completion with an event, the application
+ * calls puglWaitImage before drawing into the image again.
+ * If the MIT-SHM extension is not available (e.g. remote display)
+ * plain XPutImage is used.
+ */
+
 struct PuglInternalsImpl {
 	Display*   display;
 	int        screen;
 	Window     win;
+#ifdef PUGL_XSHM
+	Visual*    visual;
+	int        depth;
+	GC         gc;
+	XImage*    image;
+	Bool       useShm;
+	XShmSegmentInfo shminfo;
+	int        shmEventBase;
+	int        shmPending; // XShmPutImage without ShmCompletion event
+#else
 	GLXContext ctx;
 	Bool       doubleBuffered;
+#endif
 };
 
+#ifndef PUGL_XSHM
+
 /**
    Attributes for single-buffered RGBA with at least
    4 bits per color and a 16 bit depth buffer.
@@ -77,6 +106,7 @@ static int attrListDbl[] = {
 	GLX_ARB_multisample, 1,
 	None
 };
+#endif
 
 PuglView*
 puglCreate(PuglNativeWindow parent,
@@ -105,6 +135,29 @@ puglCreate(PuglNativeWindow parent,
 	impl->display = XOpenDisplay(0);
 	impl->screen  = DefaultScreen(impl->display);
 
+#ifdef PUGL_XSHM
+	XVisualInfo  vinfo;
+	XVisualInfo* vi = &vinfo;
+	if (!XMatchVisualInfo(impl->display, impl->screen, 24, TrueColor, vi)) {
+		fprintf(stderr, "puGL: no 24bit TrueColor visual available\n");
+		XCloseDisplay(impl->display);
+		free(view);
+		free(impl);
+		return NULL;
+	}
+	impl->visual = vi->visual;
+	impl->depth  = vi->depth;
+
+	int shmMajor, shmMinor;
+	Bool shmPixmaps;
+	impl->useShm = XShmQueryVersion(impl->display, &shmMajor, &shmMinor, &shmPixmaps);
+	if (impl->useShm) {
+		impl->shmEventBase = XShmGetEventBase(impl->display);
+	}
+#ifdef VERBOSE_PUGL
+	printf("puGL: MIT-SHM %s\n", impl->useShm ? "available" : "not available");
+#endif
+#else
 	XVisualInfo* vi = glXChooseVisual(impl->display, impl->screen, attrListDbl);
 	if (!vi) {
 		vi = glXChooseVisual(impl->display, impl->screen, attrListSgl);
@@ -126,6 +179,7 @@ puglCreate(PuglNativeWindow parent,
 #endif
 
 	impl->ctx = glXCreateContext(impl->display, vi, 0, GL_TRUE);
+#endif
 
 	Window xParent = parent
 		? (Window)parent
@@ -138,6 +192,9 @@ puglCreate(PuglNativeWindow parent,
 	memset(&attr, 0, sizeof(XSetWindowAttributes));
 	attr.colormap     = cmap;
 	attr.border_pixel = 0;
+#ifdef PUGL_XSHM
+	attr.background_pixel = 0; // clear exposed areas outside the image
+#endif
 
 	attr.event_mask = ExposureMask | KeyPressMask | KeyReleaseMask
 		| ButtonPressMask | ButtonReleaseMask
@@ -149,7 +206,11 @@ puglCreate(PuglNativeWindow parent,
 	impl->win = XCreateWindow(
 		impl->display, xParent,
 		0, 0, view->width, view->height, 0, vi->depth, InputOutput, vi->visual,
-		CWBorderPixel | CWColormap | CWEventMask, &attr);
+		CWBorderPixel | CWColormap | CWEventMask
+#ifdef PUGL_XSHM
+		| CWBackPixel
+#endif
+		, &attr);
 
 	XSizeHints sizeHints;
 	memset(&sizeHints, 0, sizeof(sizeHints));
@@ -191,6 +252,9 @@ puglCreate(PuglNativeWindow parent,
 		XMapRaised(impl->display, impl->win);
 	}
 
+#ifdef PUGL_XSHM
+	impl->gc = XCreateGC(impl->display, impl->win, 0, NULL);
+#else
 	if (glXIsDirect(impl->display, impl->ctx)) {
 #ifdef VERBOSE_PUGL
 		printf("puGL: DRI enabled\n");
@@ -202,9 +266,159 @@ puglCreate(PuglNativeWindow parent,
 	}
 
 	XFree(vi);
+#endif
 	return view;
 }
 
+#ifdef PUGL_XSHM
+static int shmAttachFailed = 0;
+
+static int
+puglShmErrorHandler(Display* display, XErrorEvent* event)
+{
+	shmAttachFailed = 1;
+	return 0;
+}
+
+static void
+puglFreeImage(PuglView* view)
+{
+	PuglInternals* impl = view->impl;
+	if (!impl->image) {
+		return;
+	}
+	if (impl->useShm) {
+		puglWaitImage(view);
+		XShmDetach(impl->display, &impl->shminfo);
+		XSync(impl->display, False);
+		impl->image->data = NULL; // not malloc()ed
+		XDestroyImage(impl->image);
+		shmdt(impl->shminfo.shmaddr);
+	} else {
+		XDestroyImage(impl->image); // also frees data
+	}
+	impl->image = NULL;
+}
+
+static XImage*
+puglCreateShmImage(PuglView* view, int width, int height)
+{
+	PuglInternals* impl = view->impl;
+	XImage* img = XShmCreateImage(impl->display, impl->visual, impl->depth,
+			ZPixmap, NULL, &impl->shminfo, width, height);
+	if (!img) {
+		return NULL;
+	}
+	impl->shminfo.shmid = shmget(IPC_PRIVATE,
+			img->bytes_per_line * img->height, IPC_CREAT | 0600);
+	if (impl->shminfo.shmid < 0) {
+		XDestroyImage(img);
+		return NULL;
+	}
+	impl->shminfo.shmaddr = img->data = (char*) shmat(impl->shminfo.shmid, 0, 0);
+	impl->shminfo.readOnly = False;
+	if (impl->shminfo.shmaddr == (char*) -1) {
+		shmctl(impl->shminfo.shmid, IPC_RMID, 0);
+		img->data = NULL;
+		XDestroyImage(img);
+		return NULL;
+	}
+
+	/* XShmAttach fails asynchronously for remote displays */
+	XSync(impl->display, False);
+	shmAttachFailed = 0;
+	XErrorHandler oldHandler = XSetErrorHandler(puglShmErrorHandler);
+	XShmAttach(impl->display, &impl->shminfo);
+	XSync(impl->display, False);
+	XSetErrorHandler(oldHandler);
+
+	/* segment is destroyed once the last process detaches */
+	shmctl(impl->shminfo.shmid, IPC_RMID, 0);
+
+	if (shmAttachFailed) {
+		img->data = NULL;
+		XDestroyImage(img);
+		shmdt(impl->shminfo.shmaddr);
+		return NULL;
+	}
+	return img;
+}
+
+unsigned char*
+puglAllocImage(PuglView* view, int width, int height, int* stride)
+{
+	PuglInternals* impl = view->impl;
+	puglFreeImage(view);
+
+	if (impl->useShm) {
+		impl->image = puglCreateShmImage(view, width, height);
+		if (!impl->image) {
+#ifdef VERBOSE_PUGL
+			printf("puGL: MIT-SHM failed, using XPutImage\n");
+#endif
+			impl->useShm = False;
+		}
+	}
+	if (!impl->image) {
+		char* data = (char*) malloc(4 * width * height);
+		if (!data) {
+			return NULL;
+		}
+		impl->image = XCreateImage(impl->display, impl->visual, impl->depth,
+				ZPixmap, 0, data, width, height, 32, 4 * width);
+		if (!impl->image) {
+			free(data);
+			return NULL;
+		}
+	}
+	*stride = impl->image->bytes_per_line;
+	return (unsigned char*) impl->image->data;
+}
+
+void
+puglPutImage(PuglView* view, int x, int y, int width, int height, int dest_x, int dest_y)
+{
+	PuglInternals* impl = view->impl;
+	if (!impl->image) {
+		return;
+	}
+	if (impl->useShm) {
+		XShmPutImage(impl->display, impl->win, impl->gc, impl->image,
+				x, y, dest_x + x, dest_y + y, width, height, True);
+		++impl->shmPending;
+	} else {
+		XPutImage(impl->display, impl->win, impl->gc, impl->image,
+				x, y, dest_x + x, dest_y + y, width, height);
+	}
+}
+
+void
+puglFlushImage(PuglView* view)
+{
+	XFlush(view->impl->display);
+}
+
+static Bool
+puglIsShmCompletion(Display* display, XEvent* event, XPointer arg)
+{
+	PuglInternals* impl = (PuglInternals*) arg;
+	return event->type == impl->shmEventBase + ShmCompletion
+		&& ((XShmCompletionEvent*) event)->drawable == impl->win;
+}
+
+void
+puglWaitImage(PuglView* view)
+{
+	PuglInternals* impl = view->impl;
+	XEvent event;
+	while (impl->shmPending > 0) {
+		/* leaves all other events in the queue */
+		XIfEvent(impl->display, &event, puglIsShmCompletion, (XPointer) impl);
+		--impl->shmPending;
+	}
+}
+#endif
+
 void
 puglDestroy(PuglView* view)
 {
@@ -212,7 +426,12 @@ puglDestroy(PuglView* view)
 		return;
 	}
 
+#ifdef PUGL_XSHM
+	puglFreeImage(view);
+	XFreeGC(view->impl->display, view->impl->gc);
+#else
 	glXDestroyContext(view->impl->display, view->impl->ctx);
+#endif
 	XDestroyWindow(view->impl->display, view->impl->win);
 	XCloseDisplay(view->impl->display);
 	free(view->impl);
@@ -232,7 +451,9 @@ puglHideWindow(PuglView* view) {
 static void
 puglReshape(PuglView* view, int width, int height)
 {
+#ifndef PUGL_XSHM
 	glXMakeCurrent(view->impl->display, view->impl->win, view->impl->ctx);
+#endif
 
 	if (view->reshapeFunc) {
 		view->reshapeFunc(view, width, height);
@@ -247,21 +468,41 @@ puglReshape(PuglView* view, int width, int height)
 static void
 puglDisplay(PuglView* view)
 {
+#ifndef PUGL_XSHM
 	glXMakeCurrent(view->impl->display, view->impl->win, view->impl->ctx);
+#endif
 #if 0
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	glLoadIdentity();
 #endif
 
 	view->redisplay = false;
+	view->skip_frame = false;
+	view->swapped = false;
 	if (view->displayFunc) {
 		view->displayFunc(view);
 	}
 
+	if (view->skip_frame && !view->expose) {
+		return;
+	}
+	view->expose = false;
+
+	if (!view->swapped) {
+		puglSwapBuffers(view);
+	}
+}
+
+void
+puglSwapBuffers(PuglView* view)
+{
+	view->swapped = true;
+#ifndef PUGL_XSHM
 	glFlush();
 	if (view->impl->doubleBuffered) {
 		glXSwapBuffers(view->impl->display, view->impl->win);
 	}
+#endif
 }
 
 static void
@@ -366,6 +607,7 @@ puglProcessEvents(PuglView* view)
 			if (event.xexpose.count != 0) {
 				break;
 			}
+			view->expose = true;
 			puglDisplay(view);
 			break;
 		case MotionNotify:
@@ -462,6 +704,12 @@ puglProcessEvents(PuglView* view)
 			break;
 #endif
 		default:
+#ifdef PUGL_XSHM
+			if (view->impl->useShm && view->impl->shmPending > 0
+			    && event.type == view->impl->shmEventBase + ShmCompletion) {
+				--view->impl->shmPending;
+			}
+#endif
 			break;
 		}
 	}
@@ -494,3 +742,16 @@ puglGetNativeWindow(PuglView* view)
 {
 	return view->impl->win;
 }
+
+int
+puglGetEventFd(PuglView* view)
+{
+	return ConnectionNumber(view->impl->display);
+}
+
+bool
+puglHasPendingEvents(PuglView* view)
+{
+	XFlush(view->impl->display);
+	return XEventsQueued(view->impl->display, QueuedAlready) > 0;
+}
@@ -103,7 +103,7 @@ typedef struct _robwidget {
 
 	/* internal - GL */
 #ifndef GTK_BACKEND
-	void* top;
+	void* top; // toplevel handle, propagated to all children
 	struct _robwidget* parent;
 	struct _robwidget **children;
 	unsigned int childcount;
@@ -112,6 +112,26 @@ typedef struct _robwidget {
 	bool resized; // full-redraw --containers after resize
 	bool hidden; // don't display, skip in layout and events
 	int  packing_opts;
+#ifdef PROFILE_EXPOSE
+	void *profile; // gl/profile.h
+#endif
+	void *hit_index; // gl/hitindex.h
+	cairo_rectangle_t ft_area; // pending queue_tiny_rect() area, merged
+	bool ft_queued; // widget is in the fast-track queue
+	bool ft_lock;   // protects ft_area, ft_queued
+	bool retained;  // leaf is rendered into 'cache', see robwidget_set_retained()
+	bool layer;     // leaf has its own GL texture, see robwidget_set_layer()
+	bool opaque;    // expose paints the complete area, see robwidget_set_opaque()
+	bool cache_dirty;
+	cairo_surface_t *cache;
+	float cache_scale, cache_w, cache_h;
+	int  req_w, req_h;     // last size request, see robwidget_size_request()
+	int  alloc_w, alloc_h; // last allocation, see robwidget_size_allocate()
+	float alloc_area_w, alloc_area_h; // resulting size
+	bool req_valid;        // req_w, req_h are current, see robwidget_size_changed()
+	bool alloc_valid;
+	bool allocated;        // area is the allocation for the current request
+	unsigned int layout_gen; // toplevel: changed by robwidget_layout_invalidate()
 #endif
 	float xalign, yalign; // unused in GTK
 	cairo_rectangle_t area; // allocated pos + size
@@ -231,7 +251,10 @@ static float rtk_hue2rgb(const float p, const float q, float t) {
 #else
 
 #include "gl/common_cgl.h"
+#include "gl/overdraw.h"
+#include "gl/hitindex.h"
 #include "gl/robwidget_gl.h"
+#include "gl/profile.h"
 #include "gl/layout.h"
 
 #endif
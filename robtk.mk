@@ -8,6 +8,8 @@ UITOOLKIT=$(WD)checkbutton.h $(WD)dial.h $(WD)label.h $(WD)pushbutton.h\
 
 ROBGL= $(RW)robtk.mk $(UITOOLKIT) $(RW)ui_gl.c $(PUGL_SRC) \
   $(RW)gl/common_cgl.h $(RW)gl/layout.h $(RW)gl/robwidget_gl.h $(RW)robtk.h \
+  $(RW)gl/ringbuf.h $(RW)gl/stats.h $(RW)gl/profile.h $(RW)gl/damage.h \
+  $(RW)gl/overdraw.h $(RW)gl/hitindex.h \
 	$(RT)common.h $(RT)style.h \
   $(RW)gl/xternalui.c $(RW)gl/xternalui.h
 
@@ -34,3 +36,24 @@ ROBGTK = $(RW)robtk.mk $(UITOOLKIT) $(RW)ui_gtk.c \
 	  -shared $(LV2LDFLAGS) $(LDFLAGS) $(GLUILIBS)
 	strip -x $@
 
+
+# software rendering via X11 MIT-SHM, no openGL (drop-in for %UI_gl.so)
+SHMUILIBS ?= $(filter-out -lGL -lGLU,$(GLUILIBS)) -lXext
+
+%UI_shm.so:: $(ROBGL)
+	@mkdir -p $(@D)
+	$(CXX) $(CPPFLAGS) $(CFLAGS) $(GLUICFLAGS) -DPUGL_XSHM \
+	  -DPLUGIN_SOURCE="\"gui/$(*F).c\"" \
+	  -o $@ $(RW)ui_gl.c \
+	  $(PUGL_SRC) \
+	  $(value $(*F)_UISRC) \
+	  -shared $(LV2LDFLAGS) $(LDFLAGS) $(SHMUILIBS)
+	strip -x $@
+
+
+# micro-benchmark of gl/ringbuf.h, not built by default:
+#   make -f robtk.mk ringbuf_bench
+ROBTK_DEFAULT_GOAL := $(.DEFAULT_GOAL)
+ringbuf_bench: $(RW)gl/ringbuf_bench.c $(RW)gl/ringbuf.h
+	$(CC) $(CPPFLAGS) -O2 -Wall -Wno-unused-function -std=gnu99 -o $@ $(RW)gl/ringbuf_bench.c -lpthread
+.DEFAULT_GOAL := $(ROBTK_DEFAULT_GOAL)
@@ -107,17 +107,55 @@ static void write_text_full(
 	cairo_new_path (cr);
 }
 
-static void create_text_surface(cairo_surface_t ** sf,
+/* pre-rendered surfaces are kept at the resolution of the target.
+ * The scale is rounded up to quarter steps, so caches are not
+ * re-created for every zoom-step.
+ */
+static float rtk_cache_scale(cairo_t *cr) {
+	double x = 1.0, y = 0.0;
+	cairo_user_to_device_distance(cr, &x, &y);
+	const double s = sqrt(x * x + y * y);
+	if (s <= 1.0) return 1.0;
+	return ceil(s * 4.0) / 4.0;
+}
+
+/* image surface for w x h user units at given scale, the returned
+ * context (if cr is not NULL) draws in user units */
+static cairo_surface_t* rtk_cache_surface_create(const float w, const float h, const float scale, cairo_t **cr) {
+	cairo_surface_t* sf = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, ceilf(w * scale), ceilf(h * scale));
+	if (cr) {
+		*cr = cairo_create (sf);
+		cairo_scale (*cr, scale, scale);
+	}
+	return sf;
+}
+
+/* like cairo_set_source_surface() for surfaces created with
+ * rtk_cache_surface_create() */
+static void rtk_set_source_cache(cairo_t *cr, cairo_surface_t *sf, const float x, const float y, const float scale) {
+	if (scale == 1.0) {
+		cairo_set_source_surface(cr, sf, x, y);
+		return;
+	}
+	cairo_matrix_t m;
+	cairo_set_source_surface(cr, sf, 0, 0);
+	cairo_matrix_init_scale(&m, scale, scale);
+	cairo_matrix_translate(&m, -x, -y);
+	cairo_pattern_set_matrix(cairo_get_source(cr), &m);
+}
+
+static void create_text_surface_scaled(cairo_surface_t ** sf,
 		const float w, const float h,
 		const float x, const float y,
-		const char * txt, PangoFontDescription *font, float *c_col) {
+		const char * txt, PangoFontDescription *font, float *c_col,
+		const float scale) {
 	assert(sf);
 
 	if (*sf) {
 		cairo_surface_destroy(*sf);
 	}
-	*sf = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h);
-	cairo_t *cr = cairo_create (*sf);
+	cairo_t *cr;
+	*sf = rtk_cache_surface_create(w, h, scale, &cr);
 	cairo_set_source_rgba (cr, .0, .0, .0, 0);
 	cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
 	cairo_rectangle (cr, 0, 0, w, h);
@@ -129,4 +167,11 @@ static void create_text_surface(cairo_surface_t ** sf,
 	cairo_destroy (cr);
 }
 
+static void create_text_surface(cairo_surface_t ** sf,
+		const float w, const float h,
+		const float x, const float y,
+		const char * txt, PangoFontDescription *font, float *c_col) {
+	create_text_surface_scaled(sf, w, h, x, y, txt, font, c_col, 1.0);
+}
+
 #endif
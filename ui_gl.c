@@ -22,15 +22,22 @@
 
 //#define THREADSYNC // wake up GUI thread on port-event
 
+#define UI_MAX_FPS 60 // redraw rate limit of the event-driven GUI thread
+//#define NO_SHARED_UI_THREAD // one event-driven GUI thread per plugin instance
+
 #ifdef XTERNAL_UI
 //#  define INIT_PUGL_IN_THREAD // don't share X11 connection w/host
 #endif
 
 #define TIMED_RESHAPE // resize view when idle
 
+//#define USE_GL_PBO // asynchronous texture upload via pixel-buffer-objects
+
 //#define DEBUG_RESIZE
 //#define DEBUG_EXPOSURE
 //#define VISIBLE_EXPOSE
+//#define PROFILE_EXPOSE // per widget expose timing, printed on cleanup
+//#define PROFILE_HEATMAP // overlay widget redraw-rate on the canvas
 //#define DEBUG_UI
 
 /* either USE_GUI_THREAD or HAVE_IDLE_IFACE needs to be defined.
@@ -54,10 +61,58 @@
  * performance (the host's idle call's timing is inaccurate and
  * using the idle interface will also slow down the host's UI...
  */
+#if (defined PROFILE_HEATMAP && !defined PROFILE_EXPOSE)
+# define PROFILE_EXPOSE
+#endif
+
 #if (!defined HAVE_IDLE_IFACE && !defined USE_GUI_THREAD)
 #error At least one of HAVE_IDLE_IFACE or USE_GUI_THREAD must be defined.
 #endif
 
+/* EVENT_DRIVEN_UI: the GUI thread sleeps in poll() on the X11 connection
+ * and a wakeup fd (signalled by port-events and queue_draw*) instead of
+ * polling at a fixed rate. Redraws are rate-limited to UI_MAX_FPS,
+ * input events are handled immediately.
+ */
+#if (defined USE_GUI_THREAD && !defined _WIN32 && !defined __APPLE__)
+# define EVENT_DRIVEN_UI
+# ifndef NO_SHARED_UI_THREAD
+#  define SHARED_UI_THREAD
+# endif
+# undef THREADSYNC
+#endif
+
+/* SHARED_UI_THREAD: rather than one thread per plugin-GUI instance,
+ * a single GUI thread services all instances (of this .so) and only
+ * handles views with pending events or damage.
+ * Enabled with EVENT_DRIVEN_UI unless NO_SHARED_UI_THREAD is defined.
+ */
+
+/* USE_GL_PBO: the canvas is copied into a (orphaned) pixel-buffer-object
+ * and the texture is updated from there. The copy to the PBO is cheap
+ * and the driver performs the actual texture upload asynchronously,
+ * while cairo already renders the next frame.
+ * The PBO is orphaned every frame: the driver provides fresh storage
+ * while a previous transfer may still be pending. If the GL implementation lacks
+ * GL_ARB_pixel_buffer_object the direct upload is used instead.
+ */
+
+/* PUGL_XSHM: software rendering without openGL,
+ * the cairo canvas is an X11 shared-memory image and modified
+ * parts are copied to the window with XShmPutImage.
+ */
+#ifdef PUGL_XSHM
+# undef USE_GL_PBO
+#endif
+
+#ifdef USE_GL_PBO
+# ifdef _WIN32
+#  error "USE_GL_PBO is not supported on Windows"
+# else
+#  define GL_GLEXT_PROTOTYPES
+# endif
+#endif
+
 #define _POSIX_C_SOURCE 200809L
 
 #include <stdio.h>
@@ -68,9 +123,20 @@
 #include <pthread.h>
 #include <assert.h>
 
+#ifdef EVENT_DRIVEN_UI
+#include <poll.h>
+#include <fcntl.h>
+#include <errno.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+#endif
+
 #include "pugl/pugl.h"
 
-#ifdef __APPLE__
+#ifdef PUGL_XSHM
+/* no openGL */
+#elif defined __APPLE__
 #include "OpenGL/glu.h"
 #else
 #include <GL/glu.h>
@@ -86,9 +152,12 @@
 
 #define ROBTK_MOD_SHIFT PUGL_MOD_SHIFT
 #define ROBTK_MOD_CTRL PUGL_MOD_CTRL
-#include "gl/posringbuf.h"
+#include "gl/ringbuf.h"
 #include "robtk.h"
+#include "gl/stats.h"
+#include "gl/damage.h"
 
+#ifndef PUGL_XSHM
 static void opengl_init () {
 	glClearColor (0.0f, 0.0f, 0.0f, 0.0f);
 	glDisable (GL_DEPTH_TEST);
@@ -108,9 +177,6 @@ static void opengl_draw (int width, int height, unsigned char* surf_data, unsign
 
 	glEnable(GL_TEXTURE_2D);
 	glBindTexture(GL_TEXTURE_RECTANGLE_ARB, texture_id);
-	glTexImage2D(GL_TEXTURE_RECTANGLE_ARB, 0, GL_RGBA,
-			width, height, /*border*/ 0,
-			GL_BGRA, GL_UNSIGNED_BYTE, surf_data);
 
 	glBegin(GL_QUADS);
 	glTexCoord2f(           0.0f, (GLfloat) height);
@@ -130,14 +196,111 @@ static void opengl_draw (int width, int height, unsigned char* surf_data, unsign
 	glPopMatrix();
 }
 
-static void opengl_reallocate_texture (int width, int height, unsigned int* texture_id) {
+/* widget with its own texture, see robwidget_set_layer() */
+typedef struct {
+	RobWidget*   rw;
+	unsigned int texture_id;
+	int          tex_w; // texture size, device pixels
+	int          tex_h;
+} GlLayer;
+
+/* upload an image surface to a layer texture */
+static void opengl_layer_upload (GlLayer *l, cairo_surface_t *sf) {
+	const int w = cairo_image_surface_get_width (sf);
+	const int h = cairo_image_surface_get_height (sf);
+	if (!l->texture_id) {
+		glGenTextures (1, &l->texture_id);
+	}
+	glBindTexture (GL_TEXTURE_RECTANGLE_ARB, l->texture_id);
+	glPixelStorei (GL_UNPACK_ROW_LENGTH, cairo_image_surface_get_stride (sf) / 4);
+	if (w != l->tex_w || h != l->tex_h) {
+		glTexImage2D (GL_TEXTURE_RECTANGLE_ARB, 0, GL_RGBA,
+				w, h, 0,
+				GL_BGRA, GL_UNSIGNED_BYTE, cairo_image_surface_get_data (sf));
+		l->tex_w = w;
+		l->tex_h = h;
+	} else {
+		glTexSubImage2D (GL_TEXTURE_RECTANGLE_ARB, 0,
+				0, 0, w, h,
+				GL_BGRA, GL_UNSIGNED_BYTE, cairo_image_surface_get_data (sf));
+	}
+	glPixelStorei (GL_UNPACK_ROW_LENGTH, 0);
+}
+
+/* draw layer texture at x, y (device pixels) on top of a width x height canvas */
+static void opengl_layer_draw (const GlLayer *l, float x, float y, int width, int height) {
+	const GLfloat x0 = -1.0f + 2.0f * x / width;
+	const GLfloat x1 = -1.0f + 2.0f * (x + l->tex_w) / width;
+	const GLfloat y0 =  1.0f - 2.0f * y / height;
+	const GLfloat y1 =  1.0f - 2.0f * (y + l->tex_h) / height;
+
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_RECTANGLE_ARB, l->texture_id);
+	/* cairo data is pre-multiplied, blend it over the canvas */
+	glTexEnvi (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+	glBlendFunc (GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+	glBegin(GL_QUADS);
+	glTexCoord2f(           0.0f, (GLfloat) l->tex_h);
+	glVertex2f(x0, y1);
+
+	glTexCoord2f((GLfloat) l->tex_w, (GLfloat) l->tex_h);
+	glVertex2f(x1, y1);
+
+	glTexCoord2f((GLfloat) l->tex_w, 0.0f);
+	glVertex2f(x1, y0);
+
+	glTexCoord2f(            0.0f, 0.0f);
+	glVertex2f(x0, y0);
+	glEnd();
+
+	glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glTexEnvi (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_DECAL);
+	glDisable(GL_TEXTURE_2D);
+}
+
+/* copy the given (integer) rectangle of the canvas to the texture
+ * row_length: canvas stride in pixels
+ * surf_data is an offset if a GL_PIXEL_UNPACK_BUFFER is bound.
+ */
+static void opengl_upload (int row_length, unsigned char* surf_data, unsigned int texture_id, const cairo_rectangle_t *r) {
+	glBindTexture(GL_TEXTURE_RECTANGLE_ARB, texture_id);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, row_length);
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, r->x);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, r->y);
+	glTexSubImage2D(GL_TEXTURE_RECTANGLE_ARB, 0,
+			r->x, r->y, r->width, r->height,
+			GL_BGRA, GL_UNSIGNED_BYTE, surf_data);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+}
+
+#ifdef USE_GL_PBO
+static bool opengl_have_pbo () {
+	const char *ext = (const char*) glGetString (GL_EXTENSIONS);
+	return ext && strstr (ext, "GL_ARB_pixel_buffer_object");
+}
+
+static void opengl_reallocate_pbo (int width, int height, unsigned int* pbo) {
+	glDeleteBuffers (1, pbo);
+	glGenBuffers (1, pbo);
+	glBindBuffer (GL_PIXEL_UNPACK_BUFFER, *pbo);
+	glBufferData (GL_PIXEL_UNPACK_BUFFER, 4 * width * height, NULL, GL_STREAM_DRAW);
+	glBindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+}
+#endif
+
+static void opengl_reset (int width, int height) {
 	glViewport (0, 0, width, height);
 	glMatrixMode (GL_PROJECTION);
 	glLoadIdentity ();
 	glOrtho (-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
 
 	glClear (GL_COLOR_BUFFER_BIT);
+}
 
+static void opengl_reallocate_texture (int width, int height, unsigned int* texture_id) {
 	glDeleteTextures (1, texture_id);
 	glGenTextures (1, texture_id);
 	glBindTexture (GL_TEXTURE_RECTANGLE_ARB, *texture_id);
@@ -147,39 +310,100 @@ static void opengl_reallocate_texture (int width, int height, unsigned int* text
 	glTexEnvi (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_DECAL);
 }
 
-static cairo_t* opengl_create_cairo_t ( int width, int height, cairo_surface_t** surface, unsigned char** buffer)
+static unsigned char* opengl_alloc_canvas (int width, int height, int* stride)
 {
-	cairo_t* cr;
 	const int bpp = 4;
-
-	*buffer = (unsigned char*) calloc (bpp * width * height, sizeof (unsigned char));
-	if (!*buffer) {
+	unsigned char* buffer = (unsigned char*) malloc (bpp * width * height);
+	if (!buffer) {
 		fprintf (stderr, "meters.lv2: opengl surface out of memory.\n");
 		return NULL;
 	}
+	*stride = bpp * width;
+	return buffer;
+}
+
+static void opengl_viewport (int x, int y, int width, int height) {
+	glViewport (x, y, width, height);
+}
+
+#else
+
+static unsigned char* xshm_alloc_canvas (PuglView* view, int width, int height, int* stride)
+{
+	unsigned char* buffer = puglAllocImage (view, width, height, stride);
+	if (!buffer) {
+		fprintf (stderr, "meters.lv2: cannot allocate X11 image.\n");
+		return NULL;
+	}
+	return buffer;
+}
+
+static void opengl_viewport (int x, int y, int width, int height) { }
+
+#endif
+
+/* cairo context for a width x height view into an existing buffer */
+static cairo_t* canvas_create_cairo_t (int width, int height, int stride, unsigned char* buffer, cairo_surface_t** surface)
+{
+	cairo_t* cr;
 
-	*surface = cairo_image_surface_create_for_data (*buffer,
-			CAIRO_FORMAT_ARGB32, width, height, bpp * width);
+	*surface = cairo_image_surface_create_for_data (buffer,
+			CAIRO_FORMAT_ARGB32, width, height, stride);
 	if (cairo_surface_status (*surface) != CAIRO_STATUS_SUCCESS) {
-		free (*buffer);
 		fprintf (stderr, "meters.lv2: failed to create cairo surface\n");
+		cairo_surface_destroy (*surface);
+		*surface = NULL;
 		return NULL;
 	}
 
 	cr = cairo_create (*surface);
 	if (cairo_status (cr) != CAIRO_STATUS_SUCCESS) {
-		free (*buffer);
 		fprintf (stderr, "meters.lv2: cannot create cairo context\n");
+		cairo_destroy (cr);
+		cairo_surface_destroy (*surface);
+		*surface = NULL;
 		return NULL;
 	}
 
 	return cr;
 }
 
+/* canvas memory (and texture) is kept across resizes:
+ * grow geometrically, shrink only when less than half is used.
+ */
+#define CANVAS_ALIGN 64 // [px]
+
+static int canvas_capacity (int need, int have) {
+	if (need <= have && 2 * need >= have) {
+		return have;
+	}
+	int cap = need;
+	if (need > have && have > 0) {
+		cap = MAX(need, have + have / 2);
+	}
+	return (cap + CANVAS_ALIGN - 1) & ~(CANVAS_ALIGN - 1);
+}
+
 /*****************************************************************************/
 
 #include "gl/xternalui.h"
 
+/* fast-track queue capacity
+ * a widget is queued at most once, so this defaults to the number
+ * of widgets. A plugin can override it by defining LVGL_FASTTRACK_QUEUE.
+ * The queue grows (up to FASTTRACK_MAX) when it overflows.
+ */
+#define FASTTRACK_MIN 48
+#define FASTTRACK_MAX 4096
+#define FASTTRACK_RETIRED 8
+
+/* a fast-track widget and its area, taken from the queue for one frame */
+typedef struct {
+	RobWidget *rw;
+	cairo_rectangle_t a; // widget coordinates
+	cairo_rectangle_t t; // layout coordinates
+} FastTrackItem;
+
 typedef struct {
 	PuglView*            view;
 	LV2UI_Resize*        resize;
@@ -195,6 +419,12 @@ typedef struct {
 	int                  xoff;
 	int                  yoff;
 	float                xyscale;
+	float                canvas_scale; // device pixels per layout pixel (zoom)
+	int                  canvas_w; // canvas size in device pixels
+	int                  canvas_h;
+	int                  canvas_cap_w; // allocated canvas and texture size
+	int                  canvas_cap_h;
+	int                  canvas_stride; // [bytes]
 	bool                 gl_initialized;
 #ifdef INIT_PUGL_IN_THREAD
 	bool                 ui_initialized;
@@ -217,17 +447,47 @@ typedef struct {
 	cairo_surface_t* surface;
 	unsigned char*   surf_data;
 	unsigned int     texture_id;
+#ifdef USE_GL_PBO
+	bool             use_pbo;
+	unsigned int     pbo;
+#endif
+#ifndef PUGL_XSHM
+	GlLayer*         layers; // widgets with their own texture
+	int              layer_cnt;
+	int              layers_dirty; // re-collect layers, set by any thread
+#endif
+
+	/* parts of the canvas modified since last upload, device pixels */
+	RtkDamage         dirty;
+	bool              dirty_full;
+
+	/* frames with/without damage */
+	uint64_t          frames_presented;
+	uint64_t          frames_skipped;
+
+	/* timing instrumentation, see gl/stats.h */
+	RtkStats          stats;
 
 	/* top-level */
 	RobWidget    *tl;
 	LV2UI_Handle  ui;
 
 	/* toolkit state stuff */
-	volatile cairo_rectangle_t expose_area;
+	RtkDamageQueue damage_queue; // queue_draw_*() from any thread
+	RtkDamage expose_area; // parts to be redrawn, layout coordinates (GUI thread)
+	RobDisplayList display_list; // leaf widgets in paint order, rebuilt after layout
+#ifdef DEBUG_OVERDRAW
+	RtkOverdraw overdraw;
+#endif
 	RobWidget *mousefocus;
 	RobWidget *mousehover;
 
-	posringbuf *rb;
+	RtkRing *rb; // fast-track queue, RobWidget*; replaced by a larger one on overflow
+	RtkRing *rb_retired[FASTTRACK_RETIRED]; // previous queues, kept until cleanup
+	int      rb_retired_cnt;
+	uint32_t rb_overflow; // since last frame, any thread
+	FastTrackItem *ft_items; // cairo_expose() scratch
+	uint32_t       ft_items_size;
 
 #if (defined USE_GUI_THREAD && defined HAVE_IDLE_IFACE)
 	bool do_the_funky_resize;
@@ -242,6 +502,18 @@ typedef struct {
 	pthread_cond_t data_ready;
 #endif
 
+#ifdef EVENT_DRIVEN_UI
+	int          wakeup_fd[2]; // read, write (same fd with eventfd)
+	volatile int wakeup_pending;
+	uint64_t     next_frame;
+#endif
+#ifdef SHARED_UI_THREAD
+	bool         sched_active;  // serviced by the shared thread
+	bool         sched_remove;  // cleanup requested
+	bool         sched_deferred; // closed by a callback, the thread calls gl_free()
+	bool         sched_xready;  // X11 connection is readable
+#endif
+
 } GlMetersLV2UI;
 
 /*****************************************************************************/
@@ -250,6 +522,8 @@ typedef struct {
 
 /*****************************************************************************/
 
+static void ui_wakeup(GlMetersLV2UI* self);
+
 #include "gl/xternalui.c"
 
 static void reallocate_canvas(GlMetersLV2UI* self);
@@ -257,131 +531,342 @@ static void reallocate_canvas(GlMetersLV2UI* self);
 /*****************************************************************************/
 /* RobWidget implementation & glue */
 
-typedef struct {
-	RobWidget *rw;
-	cairo_rectangle_t a;
-} RWArea;
+/* keep track of exposed canvas areas, for partial texture upload */
+/* a: area in layout coordinates, self->dirty: device pixels */
+static void canvas_mark_dirty(GlMetersLV2UI * self, const cairo_rectangle_t *a) {
+	if (self->dirty_full) return;
+	const float s = self->canvas_scale;
+	cairo_rectangle_t r;
+	r.x      = MAX(0, floor(a->x * s));
+	r.y      = MAX(0, floor(a->y * s));
+	r.width  = MIN(self->canvas_w, ceil((a->x + a->width) * s))  - r.x;
+	r.height = MIN(self->canvas_h, ceil((a->y + a->height) * s)) - r.y;
+	rtk_damage_add(&self->dirty, &r);
+}
 
-static void cairo_expose(GlMetersLV2UI * self) {
+#ifdef USE_GL_PBO
+static void canvas_upload_pbo(GlMetersLV2UI * self) {
+	const int stride = self->canvas_stride;
+	cairo_rectangle_t full = {0, 0, (double)self->canvas_w, (double)self->canvas_h};
+	const cairo_rectangle_t *r = self->dirty_full ? &full : self->dirty.r;
+	const int n_rects = self->dirty_full ? 1 : self->dirty.cnt;
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, self->pbo);
+	/* orphan previous storage, don't wait for a pending transfer */
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, stride * self->canvas_h, NULL, GL_STREAM_DRAW);
+	unsigned char *dst = (unsigned char*) glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+	if (!dst) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		self->use_pbo = false;
+		self->dirty_full = true;
+		return;
+	}
 
-	/* FAST TRACK EXPOSE */
-	int qq = posrb_read_space(self->rb) / sizeof(RWArea);
-	bool dirty = qq > 0;
-#ifdef DEBUG_FASTTRACK
-	/*if (qq > 0)*/ fprintf(stderr, " fast track %d events\n", qq);
-#endif
-	cairo_rectangle_t fast_track_area = {0,0,0,0};
-	uint32_t fast_track_cnt = 0;
-	while (--qq >= 0) {
-		RWArea a;
-		posrb_read(self->rb, (uint8_t*) &a, sizeof(RWArea));
-		assert(a.rw);
-
-		/* skip duplicates */
-		if (fast_track_cnt > 0) {
-			if (   a.a.x+a.rw->trel.x >= fast_track_area.x
-					&& a.a.y+a.rw->trel.y >= fast_track_area.y
-					&& a.a.x+a.rw->trel.x+a.a.width  <= fast_track_area.x + fast_track_area.width
-					&& a.a.y+a.rw->trel.y+a.a.height <= fast_track_area.y + fast_track_area.height) {
-#ifdef DEBUG_FASTTRACK
-				fprintf(stderr, " skip fast-track event #%d (%.1f x %.1f + %.1f + %.1f)\n", fast_track_cnt,
-						a.a.width, a.a.height, a.a.x+a.rw->trel.x, a.a.y+a.rw->trel.y);
-#endif
-				continue;
-			}
+	/* use same layout as canvas, copy only modified parts */
+	for (int i = 0; i < n_rects; ++i) {
+		const int x0 = r[i].x * 4;
+		const int w  = r[i].width * 4;
+		for (int y = r[i].y; y < r[i].y + r[i].height; ++y) {
+			memcpy(&dst[y * stride + x0], &self->surf_data[y * stride + x0], w);
 		}
-		cairo_save(self->cr);
-		cairo_translate(self->cr, a.rw->trel.x, a.rw->trel.y);
-		a.rw->expose_event(a.rw, self->cr, &a.a);
+	}
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
 
-		/* keep track of exposed parts */
-		a.a.x += a.rw->trel.x;
-		a.a.y += a.rw->trel.y;
-#ifdef DEBUG_FASTTRACK
-		fprintf(stderr, "                       #%d (%.1f x %.1f @ %.1f + %.1f\n", fast_track_cnt,
-						a.a.width, a.a.height, a.a.x, a.a.y);
+	for (int i = 0; i < n_rects; ++i) {
+		opengl_upload(stride / 4, NULL, self->texture_id, &r[i]);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
 #endif
-#ifndef FASTTRACK_INTERSECT
-		memcpy(&fast_track_area, &a.a, sizeof(cairo_rectangle_t));
-		fast_track_cnt++;
-#else // intersects
-		if (fast_track_cnt++ == 0) {
-			fast_track_area.x = a.a.x;
-			fast_track_area.y = a.a.y;
-			fast_track_area.width = a.a.width;
-			fast_track_area.height = a.a.height;
+
+static void canvas_upload(GlMetersLV2UI * self) {
+	if (!self->surf_data) { return; }
+	if (self->stats.enabled) {
+		uint64_t px = 0;
+		if (self->dirty_full) {
+			px = self->canvas_w * self->canvas_h;
 		} else {
-			rect_intersection(&fast_track_area, &a.a, &fast_track_area);
-			//rect_combine(&fast_track_area, &a.a, &fast_track_area);
+			px = rtk_damage_area(&self->dirty);
+		}
+		rtk_stats_add(&self->stats, RTK_STAT_DAMAGE, px);
+	}
+#ifdef PUGL_XSHM
+	const uint64_t t0 = rtk_stats_time();
+	if (self->dirty_full) {
+		puglPutImage(self->view, 0, 0, self->canvas_w, self->canvas_h, self->xoff, self->yoff);
+	} else {
+		for (int i = 0; i < self->dirty.cnt; ++i) {
+			const cairo_rectangle_t *r = &self->dirty.r[i];
+			puglPutImage(self->view, r->x, r->y, r->width, r->height, self->xoff, self->yoff);
+		}
+	}
+	puglFlushImage(self->view);
+	rtk_stats_since(&self->stats, RTK_STAT_PRESENT, t0);
+#else
+#ifdef USE_GL_PBO
+	if (self->use_pbo) {
+		canvas_upload_pbo(self);
+		if (self->use_pbo) {
+			self->dirty_full = false;
+			rtk_damage_clear(&self->dirty);
+			return;
 		}
+	}
 #endif
-
-#ifdef VISIBLE_EXPOSE
-		static int ftrk = 0;
-		static int fcol = 0;
-		ftrk = (ftrk + 1) %11;
-		fcol = (fcol + 1) %17;
-		cairo_rectangle (self->cr, 0, 0, a.rw->trel.width, a.rw->trel.height);
-		cairo_set_operator (self->cr, CAIRO_OPERATOR_OVER);
-		cairo_set_source_rgba(self->cr, .8, .5 + ftrk/25.0, .5 - fcol/40.0, .25 + ftrk/30.0);
-		cairo_fill(self->cr);
+	if (self->dirty_full) {
+		cairo_rectangle_t full = {0, 0, (double)self->canvas_w, (double)self->canvas_h};
+		opengl_upload(self->canvas_stride / 4, self->surf_data, self->texture_id, &full);
+	} else {
+		for (int i = 0; i < self->dirty.cnt; ++i) {
+			opengl_upload(self->canvas_stride / 4, self->surf_data, self->texture_id, &self->dirty.r[i]);
+		}
+	}
 #endif
+	self->dirty_full = false;
+	rtk_damage_clear(&self->dirty);
+}
 
-		cairo_restore(self->cr);
+static uint32_t fasttrack_widget_count(RobWidget *rw) {
+	uint32_t n = 1;
+	for (unsigned int i = 0; i < rw->childcount; ++i) {
+		n += fasttrack_widget_count(rw->children[i]);
 	}
+	return n;
+}
 
-	if (self->expose_area.width == 0 || self->expose_area.height == 0) {
-#ifdef DEBUG_EXPOSURE
-		fprintf(stderr, " --- NO DRAW\n");
+static void fasttrack_free(GlMetersLV2UI * self) {
+	for (int i = 0; i < self->rb_retired_cnt; ++i) {
+		rtk_ring_free(self->rb_retired[i]);
+	}
+	self->rb_retired_cnt = 0;
+	rtk_ring_free(self->rb);
+	self->rb = NULL;
+	free(self->ft_items);
+	self->ft_items = NULL;
+	self->ft_items_size = 0;
+}
+
+/* GUI thread, between frames: replace the queue with a larger one
+ * if it overflowed. Producers may still hold a reference to the
+ * previous queue, so it is kept (and drained) until cleanup. */
+static void fasttrack_adapt(GlMetersLV2UI * self) {
+	const uint32_t overflow = __atomic_exchange_n(&self->rb_overflow, 0, __ATOMIC_RELAXED);
+	if (overflow == 0) return;
+	const uint32_t cap = rtk_ring_capacity(self->rb);
+	if (cap >= FASTTRACK_MAX || self->rb_retired_cnt >= FASTTRACK_RETIRED) return;
+
+	RtkRing *rb = rtk_ring_alloc(sizeof(RobWidget*), MIN(FASTTRACK_MAX, 2 * cap + overflow));
+	if (!rb) return;
+#ifdef DEBUG_FASTTRACK
+	fprintf(stderr, " fast track queue overflow (%u): %u -> %u\n", overflow, cap, rtk_ring_capacity(rb));
 #endif
-		if (dirty) {
-			cairo_surface_mark_dirty(self->surface);
+	self->rb_retired[self->rb_retired_cnt++] = self->rb;
+	__atomic_store_n(&self->rb, rb, __ATOMIC_RELEASE);
+	self->stats.rb_capacity = rtk_ring_capacity(rb);
+	rtk_stats_count(&self->stats, &self->stats.rb_resize);
+}
+
+/* pending fast-track area of a widget, queue_tiny_rect() may be called
+ * from any thread. The lock is only held to copy the rectangle. */
+static void fasttrack_lock(RobWidget *rw) {
+	while (__atomic_test_and_set(&rw->ft_lock, __ATOMIC_ACQUIRE)) ;
+}
+
+static void fasttrack_unlock(RobWidget *rw) {
+	__atomic_clear(&rw->ft_lock, __ATOMIC_RELEASE);
+}
+
+/* get and reset the area, the widget may be queued again afterwards */
+static void fasttrack_take(RobWidget *rw, cairo_rectangle_t *a) {
+	fasttrack_lock(rw);
+	memcpy(a, &rw->ft_area, sizeof(cairo_rectangle_t));
+	rw->ft_queued = false;
+	fasttrack_unlock(rw);
+}
+
+/* widgets queued on a replaced queue are exposed with the next regular redraw */
+static void fasttrack_drain_retired(GlMetersLV2UI * self) {
+	for (int i = 0; i < self->rb_retired_cnt; ++i) {
+		RobWidget **q;
+		while ((q = (RobWidget**) rtk_ring_peek(self->rb_retired[i]))) {
+			cairo_rectangle_t r;
+			fasttrack_take(*q, &r);
+			r.x += (*q)->trel.x;
+			r.y += (*q)->trel.y;
+			rtk_damage_add(&self->expose_area, &r);
+			rtk_ring_commit(self->rb_retired[i]);
 		}
-		return;
 	}
+}
 
-#ifdef DEBUG_EXPOSURE
-	fprintf(stderr, "XPS %.1f+%.1f  %.1fx%.1f\n", self->expose_area.x, self->expose_area.y, self->expose_area.width, self->expose_area.height);
+#ifndef PUGL_XSHM
+/* GPU composited widgets, see robwidget_set_layer() */
+
+static void layers_collect(RobWidget *rw, GlLayer **layers, int *cnt) {
+	if (rw->layer && rw->childcount == 0) {
+		GlLayer *l = (GlLayer*) realloc(*layers, (*cnt + 1) * sizeof(GlLayer));
+		if (!l) return;
+		*layers = l;
+		memset(&l[*cnt], 0, sizeof(GlLayer));
+		l[(*cnt)++].rw = rw;
+	}
+	for (unsigned int i = 0; i < rw->childcount; ++i) {
+		layers_collect(rw->children[i], layers, cnt);
+	}
+}
+
+static void layers_free(GlMetersLV2UI * self) {
+	for (int i = 0; i < self->layer_cnt; ++i) {
+		glDeleteTextures (1, &self->layers[i].texture_id);
+	}
+	free(self->layers);
+	self->layers = NULL;
+	self->layer_cnt = 0;
+}
+
+/* GL context must be current.
+ * Widgets which remain a layer keep their texture */
+static void layers_rebuild(GlMetersLV2UI * self) {
+	GlLayer *layers = NULL;
+	int cnt = 0;
+	__atomic_store_n(&self->layers_dirty, 0, __ATOMIC_RELEASE);
+	layers_collect(self->tl, &layers, &cnt);
+	for (int i = 0; i < cnt; ++i) {
+		for (int j = 0; j < self->layer_cnt; ++j) {
+			if (self->layers[j].rw == layers[i].rw) {
+				layers[i] = self->layers[j];
+				self->layers[j].texture_id = 0;
+				break;
+			}
+		}
+	}
+	layers_free(self);
+	self->layers = layers;
+	self->layer_cnt = cnt;
+}
+
+/* any thread, the GL thread re-collects layers before the next frame */
+static void layers_queue_rebuild(GlMetersLV2UI * self) {
+	__atomic_store_n(&self->layers_dirty, 1, __ATOMIC_RELEASE);
+}
+
+static bool layers_need_rebuild(GlMetersLV2UI * self) {
+	return __atomic_load_n(&self->layers_dirty, __ATOMIC_ACQUIRE);
+}
+
+static bool layer_visible(RobWidget *rw) {
+	return rw->cached_position && robwidget_is_visible(rw);
+}
+
+static bool layers_have_damage(GlMetersLV2UI * self) {
+	if (layers_need_rebuild(self)) {
+		return true;
+	}
+	for (int i = 0; i < self->layer_cnt; ++i) {
+		RobWidget *rw = self->layers[i].rw;
+		if ((rw->cache_dirty || !rw->cache) && layer_visible(rw)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/* re-render and upload modified layers */
+static void layers_update(GlMetersLV2UI * self) {
+	for (int i = 0; i < self->layer_cnt; ++i) {
+		GlLayer *l = &self->layers[i];
+		if (!layer_visible(l->rw) || l->rw->area.width <= 0 || l->rw->area.height <= 0) {
+			continue;
+		}
+		if (robwidget_cache_render(l->rw, self->canvas_scale) || !l->texture_id) {
+			opengl_layer_upload(l, l->rw->cache);
+		}
+	}
+}
+
+static void layers_draw(GlMetersLV2UI * self) {
+	const float s = self->canvas_scale;
+	for (int i = 0; i < self->layer_cnt; ++i) {
+		const GlLayer *l = &self->layers[i];
+		if (!l->texture_id || !layer_visible(l->rw)) {
+			continue;
+		}
+		opengl_layer_draw(l, rintf(l->rw->trel.x * s), rintf(l->rw->trel.y * s), self->canvas_w, self->canvas_h);
+	}
+}
+#else
+static void layers_queue_rebuild(GlMetersLV2UI * self) { }
 #endif
 
-	/* make copy and clear -- should be an atomic op when using own thread */
-	cairo_rectangle_t area;
-	area.x      = self->expose_area.x;
-	area.y      = self->expose_area.y;
-	area.width  = self->expose_area.width;
-	area.height = self->expose_area.height;
+static bool canvas_has_damage(GlMetersLV2UI * self) {
+#ifndef PUGL_XSHM
+	if (layers_have_damage(self)) return true;
+#endif
+	for (int i = 0; i < self->rb_retired_cnt; ++i) {
+		if (rtk_ring_peek(self->rb_retired[i])) return true;
+	}
+	return self->dirty_full || !rtk_damage_empty(&self->dirty)
+		|| rtk_ring_peek(self->rb)
+		|| !rtk_damage_empty(&self->expose_area)
+		|| rtk_damage_queue_pending(&self->damage_queue);
+}
 
-	self->expose_area.x = 0;
-	self->expose_area.y = 0;
-	self->expose_area.width = 0;
-	self->expose_area.height = 0;
+/* containers clear their background in every damaged region after
+ * a (re)layout. Once all regions are exposed, reset the flag of
+ * widgets which were drawn, or which have no visible part.
+ * clip: visible part of the parent, relative to the toplevel */
+static void robwidget_reset_resized(RobWidget *rw, const cairo_rectangle_t *clip, const RtkDamage *damage, const int n_regions) {
+	if (rw->hidden) return;
+	cairo_rectangle_t c;
+	rect_intersection(&c, &rw->trel, clip);
+	if (rw->resized) {
+		bool exposed = c.width <= 0 || c.height <= 0;
+		for (int i = 0; i < n_regions && !exposed; ++i) {
+			exposed = rect_intersect(&c, &damage->r[i]);
+		}
+		if (exposed) {
+			rw->resized = FALSE;
+		}
+	}
+	for (unsigned int i=0; i < rw->childcount; ++i) {
+		robwidget_reset_resized(rw->children[i], &c, damage, n_regions);
+	}
+}
 
+/* redraw given area of the toplevel widget */
+static void cairo_expose_area(GlMetersLV2UI * self, const cairo_rectangle_t *area, bool flat) {
 #ifdef DEBUG_EXPOSURE
-	fprintf(stderr, "---- XPS ---\n");
+	fprintf(stderr, "XPS %.1f+%.1f  %.1fx%.1f\n", area->x, area->y, area->width, area->height);
 #endif
 
 	// intersect exposure with toplevel
 	cairo_rectangle_t expose_area;
-	expose_area.x      = MAX(0, area.x - self->tl->area.x);
-	expose_area.y      = MAX(0, area.y - self->tl->area.y);
-	expose_area.width  = MIN(area.x + area.width, self->tl->area.x + self->tl->area.width) - MAX(area.x, self->tl->area.x);
-	expose_area.height = MIN(area.y + area.height, self->tl->area.y + self->tl->area.height) - MAX(area.y, self->tl->area.y);
+	expose_area.x      = MAX(0, area->x - self->tl->area.x);
+	expose_area.y      = MAX(0, area->y - self->tl->area.y);
+	expose_area.width  = MIN(area->x + area->width, self->tl->area.x + self->tl->area.width) - MAX(area->x, self->tl->area.x);
+	expose_area.height = MIN(area->y + area->height, self->tl->area.y + self->tl->area.height) - MAX(area->y, self->tl->area.y);
 
 	if (expose_area.width < 0 || expose_area.height < 0) {
 		fprintf(stderr, " !!! EMPTY AREA\n"); return;
 	}
 
-#define XPS_NO_DRAW { fprintf(stderr, " !!! OUTSIDE DRAW %.1fx%.1f %.1f+%.1f %.1fx%.1f\n", area.x, area.y,  self->tl->area.x, self->tl->area.y, self->tl->area.width, self->tl->area.height); return; }
+#define XPS_NO_DRAW { fprintf(stderr, " !!! OUTSIDE DRAW %.1fx%.1f %.1f+%.1f %.1fx%.1f\n", area->x, area->y,  self->tl->area.x, self->tl->area.y, self->tl->area.width, self->tl->area.height); return; }
 
 #if 1
-	if (area.x > self->tl->area.x + self->tl->area.width) XPS_NO_DRAW
-	if (area.y > self->tl->area.y + self->tl->area.height) XPS_NO_DRAW
-	if (area.x < self->tl->area.x) XPS_NO_DRAW
-	if (area.y < self->tl->area.y) XPS_NO_DRAW
+	if (area->x > self->tl->area.x + self->tl->area.width) XPS_NO_DRAW
+	if (area->y > self->tl->area.y + self->tl->area.height) XPS_NO_DRAW
+	if (area->x < self->tl->area.x) XPS_NO_DRAW
+	if (area->y < self->tl->area.y) XPS_NO_DRAW
 #endif
 
+	canvas_mark_dirty(self, &expose_area);
+
 	cairo_save(self->cr);
-	self->tl->expose_event(self->tl, self->cr, &expose_area);
+	if (flat) {
+		rdisplay_list_expose(&self->display_list, self->cr, &expose_area);
+	} else {
+		robwidget_expose(self->tl, self->cr, &expose_area);
+	}
 	cairo_restore(self->cr);
 
 #ifdef VISIBLE_EXPOSE
@@ -394,11 +879,140 @@ static void cairo_expose(GlMetersLV2UI * self) {
 	cairo_set_source_rgba(self->cr, .7 + hueh / 50.0, .3, .5 - hueh/30, .25 + move/20.0);
 	cairo_fill(self->cr);
 #endif
+}
+
+static void cairo_expose(GlMetersLV2UI * self) {
+
+	/* FAST TRACK EXPOSE */
+	fasttrack_adapt(self);
+	fasttrack_drain_retired(self);
+	rtk_damage_queue_drain(&self->damage_queue, &self->expose_area, self->width, self->height);
+	uint64_t t0 = rtk_stats_time();
+	uint32_t qq = rtk_ring_read_space(self->rb);
+	bool dirty = qq > 0;
+#ifdef DEBUG_FASTTRACK
+	/*if (qq > 0)*/ fprintf(stderr, " fast track %u events\n", qq);
+#endif
+	uint32_t fast_track_cnt = 0;
+	if (qq > self->ft_items_size) {
+		FastTrackItem *it = (FastTrackItem*) realloc(self->ft_items, qq * sizeof(FastTrackItem));
+		if (it) {
+			self->ft_items = it;
+			self->ft_items_size = qq;
+		}
+	}
+	/* every widget is queued once, with the combined area of all its queue_tiny_rect() calls.
+	 * limited to what was queued when the frame started */
+	uint32_t n_items = 0;
+	for (RobWidget **q; qq > 0 && (q = (RobWidget**) rtk_ring_peek(self->rb)); --qq, rtk_ring_commit(self->rb)) {
+		RobWidget *rw = *q;
+		assert(rw);
+		cairo_rectangle_t a;
+		fasttrack_take(rw, &a);
+		cairo_rectangle_t ta = {a.x + rw->trel.x, a.y + rw->trel.y, a.width, a.height};
+		if (n_items < self->ft_items_size) {
+			FastTrackItem *it = &self->ft_items[n_items++];
+			it->rw = rw;
+			it->a = a;
+			it->t = ta;
+		} else {
+			rtk_damage_add(&self->expose_area, &ta); // out of memory
+		}
+	}
+
+	/* the regular expose below draws areas which overlap its regions:
+	 * merge them, so no pixel is drawn twice. Merging grows the
+	 * regions, repeat until all remaining areas are disjoint */
+	for (bool merged = true; merged;) {
+		merged = false;
+		for (uint32_t i = 0; i < n_items; ++i) {
+			FastTrackItem *it = &self->ft_items[i];
+			if (!it->rw || !rtk_damage_intersects(&self->expose_area, &it->t)) {
+				continue;
+			}
+#ifdef DEBUG_FASTTRACK
+			fprintf(stderr, " fast-track #%u merged into expose (%.1f x %.1f @ %.1f + %.1f)\n", i,
+					it->t.width, it->t.height, it->t.x, it->t.y);
+#endif
+			rtk_damage_add(&self->expose_area, &it->t);
+			it->rw = NULL;
+			merged = true;
+		}
+	}
+
+	for (uint32_t i = 0; i < n_items; ++i) {
+		RobWidget *rw = self->ft_items[i].rw;
+		if (!rw) {
+			continue;
+		}
+		cairo_rectangle_t a = self->ft_items[i].a;
+
+		cairo_save(self->cr);
+		cairo_translate(self->cr, rw->trel.x, rw->trel.y);
+		robwidget_expose(rw, self->cr, &a);
+
+		/* keep track of exposed parts */
+		a.x += rw->trel.x;
+		a.y += rw->trel.y;
+		canvas_mark_dirty(self, &a);
+#ifdef DEBUG_FASTTRACK
+		fprintf(stderr, "                       #%d (%.1f x %.1f @ %.1f + %.1f\n", fast_track_cnt,
+						a.width, a.height, a.x, a.y);
+#endif
+		fast_track_cnt++;
+
+#ifdef VISIBLE_EXPOSE
+		static int ftrk = 0;
+		static int fcol = 0;
+		ftrk = (ftrk + 1) %11;
+		fcol = (fcol + 1) %17;
+		cairo_rectangle (self->cr, 0, 0, rw->trel.width, rw->trel.height);
+		cairo_set_operator (self->cr, CAIRO_OPERATOR_OVER);
+		cairo_set_source_rgba(self->cr, .8, .5 + ftrk/25.0, .5 - fcol/40.0, .25 + ftrk/30.0);
+		cairo_fill(self->cr);
+#endif
+
+		cairo_restore(self->cr);
+	}
+	if (dirty) {
+		rtk_stats_since(&self->stats, RTK_STAT_FASTTRACK, t0);
+	}
+
+	if (rtk_damage_empty(&self->expose_area)) {
+#ifdef DEBUG_EXPOSURE
+		fprintf(stderr, " --- NO DRAW\n");
+#endif
+		if (dirty) {
+			cairo_surface_mark_dirty(self->surface);
+		}
+		return;
+	}
+
+	RtkDamage damage;
+	memcpy(&damage, &self->expose_area, sizeof(RtkDamage));
+	rtk_damage_clear(&self->expose_area);
+
+#ifdef DEBUG_EXPOSURE
+	fprintf(stderr, "---- XPS %d regions ---\n", damage.cnt);
+#endif
+
+	t0 = rtk_stats_time();
+	const bool flat = rdisplay_list_usable(&self->display_list);
+	const int n_regions = MIN(damage.cnt, RTK_DAMAGE_MAX);
+	for (int i = 0; i < n_regions; ++i) {
+		cairo_expose_area(self, &damage.r[i], flat);
+	}
+	if (!flat) {
+		robwidget_reset_resized(self->tl, &self->tl->trel, &damage, n_regions);
+		rdisplay_list_update(&self->display_list);
+	}
+	rtk_stats_since(&self->stats, RTK_STAT_EXPOSE, t0);
 
 	cairo_surface_mark_dirty(self->surface);
 }
 
 static void queue_draw_full(RobWidget *rw) {
+	robwidget_invalidate(rw);
 	GlMetersLV2UI * const self =
 		(GlMetersLV2UI*) robwidget_get_toplevel_handle(rw);
 	if (!self || !self->view) {
@@ -409,14 +1023,38 @@ static void queue_draw_full(RobWidget *rw) {
 	fprintf(stderr, "~~ queue_draw_full '%s'\n", ROBWIDGET_NAME(rw));
 #endif
 
-	self->expose_area.x = 0;
-	self->expose_area.y = 0;
-	self->expose_area.width = self->width;
-	self->expose_area.height = self->height;
+	rtk_damage_queue_full(&self->damage_queue);
 	puglPostRedisplay(self->view);
+	ui_wakeup(self);
+}
+
+/* called by robwidget_set_layer(), GUI thread */
+static void queue_layers_rebuild(RobWidget *rw) {
+	GlMetersLV2UI * const self =
+		(GlMetersLV2UI*) robwidget_get_toplevel_handle(rw);
+	if (!self) {
+		return; // collected after layout
+	}
+	layers_queue_rebuild(self);
+#ifdef PUGL_XSHM
+	queue_draw(rw);
+#else
+	RobWidget *p = rw->parent;
+	if (!p || p == rw) {
+		queue_draw_full(rw);
+		return;
+	}
+	/* a layer does not draw into the canvas: have the parent clear
+	 * the background below it, when it becomes a layer (its last
+	 * expose) and when it stops being one (it may not be opaque) */
+	p->resized = TRUE;
+	self->display_list.clean = false;
+	queue_draw_area(p, rw->area.x, rw->area.y, rw->area.width, rw->area.height);
+#endif
 }
 
 static void queue_draw_area(RobWidget *rw, int x, int y, int width, int height) {
+	robwidget_invalidate(rw);
 	GlMetersLV2UI * self =
 		(GlMetersLV2UI*) robwidget_get_toplevel_handle(rw);
 	if (!self || !self->view) {
@@ -424,41 +1062,42 @@ static void queue_draw_area(RobWidget *rw, int x, int y, int width, int height)
 		return;
 	}
 
+#ifndef PUGL_XSHM
+	if (rw->layer && rw->childcount == 0) {
+		/* re-rendered and composited by onDisplay(), the canvas is not affected */
+		puglPostRedisplay(self->view);
+		ui_wakeup(self);
+		return;
+	}
+#endif
+
 	if (x < 0) x = 0;
 	if (y < 0) y = 0;
 	if (x + width > rw->area.width) width = rw->area.width - x;
 	if (y + height > rw->area.height) height = rw->area.height - y;
 
-	if (self->expose_area.width == 0 || self->expose_area.height == 0) {
-		RobTkBtnEvent ev; ev.x = x; ev.y = y;
+	RobTkBtnEvent ev; ev.x = x; ev.y = y;
 #ifdef DEBUG_EXPOSURE
-		fprintf(stderr, "Q PARTIAL NEW   '%s': ", ROBWIDGET_NAME(rw));
+	fprintf(stderr, "Q PARTIAL '%s': ", ROBWIDGET_NAME(rw));
 #endif
-		offset_traverse_from_child(rw, &ev);
-#ifdef DEBUG_EXPOSURE
-		fprintf(stderr, "Q PARTIAL -> %d+%d  -> %d+%d (%dx%d)\n", x, y, ev.x, ev.y, width, height);
-#endif
-		self->expose_area.x = ev.x;
-		self->expose_area.y = ev.y;
-		self->expose_area.width = width;
-		self->expose_area.height = height;
+	if (rw->cached_position) {
+		ev.x += rw->trel.x;
+		ev.y += rw->trel.y;
 	} else {
-		RobTkBtnEvent ev; ev.x = x; ev.y = y;
-#ifdef DEBUG_EXPOSURE
-		fprintf(stderr, "Q PARTIAL AMEND '%s': ", ROBWIDGET_NAME(rw));
-#endif
 		offset_traverse_from_child(rw, &ev);
-
+	}
 #ifdef DEBUG_EXPOSURE
-		fprintf(stderr, "Q PARTIAL -> %d+%d  -> %d+%d (%dx%d)\n", x, y, ev.x, ev.y, width, height);
+	fprintf(stderr, "Q PARTIAL -> %d+%d  -> %d+%d (%dx%d)\n", x, y, ev.x, ev.y, width, height);
 #endif
 
-		cairo_rectangle_t r;
-		r.x = ev.x; r.y = ev.y;
-		r.width = width; r.height = height;
-		rect_combine((cairo_rectangle_t*) &self->expose_area, &r, (cairo_rectangle_t*) &self->expose_area);
+	cairo_rectangle_t r;
+	r.x = ev.x; r.y = ev.y;
+	r.width = width; r.height = height;
+	if (!rtk_damage_queue_push(&self->damage_queue, &r)) {
+		rtk_stats_count(&self->stats, &self->stats.damage_overflow);
 	}
 	puglPostRedisplay(self->view);
+	ui_wakeup(self);
 }
 
 static void queue_draw(RobWidget *rw) {
@@ -469,24 +1108,45 @@ static void queue_draw(RobWidget *rw) {
 }
 
 static void queue_tiny_rect(RobWidget *rw, cairo_rectangle_t *a) {
+	robwidget_invalidate(rw);
 	if (!rw->cached_position) {
 		rw->redraw_pending = true;
 		return;
 	}
 	GlMetersLV2UI * self =
-		(GlMetersLV2UI*) robwidget_get_toplevel_handle(rw);// XXX cache ?!
+		(GlMetersLV2UI*) robwidget_get_toplevel_handle(rw);
 	if (!self || !self->view) {
 		rw->redraw_pending = true;
 		return;
 	}
 
-	RWArea b;
-	b.rw = rw;
-	memcpy(&b.a, a, sizeof(cairo_rectangle_t));
-	if (posrb_write(self->rb,  (uint8_t*) &b, sizeof(RWArea))<0) {
-		queue_draw_area(rw, a->x, a->y, a->width, a->height);
+#ifndef PUGL_XSHM
+	if (rw->layer && rw->childcount == 0) {
+		puglPostRedisplay(self->view);
+		ui_wakeup(self);
+		return;
+	}
+#endif
+
+	/* merge with pending area, or queue the widget */
+	fasttrack_lock(rw);
+	if (rw->ft_queued) {
+		rect_combine(&rw->ft_area, a, &rw->ft_area);
+		fasttrack_unlock(rw);
+	} else {
+		memcpy(&rw->ft_area, a, sizeof(cairo_rectangle_t));
+		rw->ft_queued = true;
+		fasttrack_unlock(rw);
+		if (!rtk_ring_push(__atomic_load_n(&self->rb, __ATOMIC_ACQUIRE), &rw)) {
+			cairo_rectangle_t r;
+			fasttrack_take(rw, &r);
+			__atomic_fetch_add(&self->rb_overflow, 1, __ATOMIC_RELAXED);
+			rtk_stats_count(&self->stats, &self->stats.rb_overflow);
+			queue_draw_area(rw, r.x, r.y, r.width, r.height);
+		}
 	}
 	puglPostRedisplay(self->view);
+	ui_wakeup(self);
 }
 
 static void queue_tiny_area(RobWidget *rw, float x, float y, float w, float h) {
@@ -512,12 +1172,24 @@ static void robwidget_layout(GlMetersLV2UI * const self, bool setsize, bool init
 
 	int nox, noy;
 
-	self->tl->size_request(self->tl, &nox, &noy);
+#ifdef DEBUG_RESIZE
+	/* a layout of an unchanged tree must not re-compute any request */
+	bool tree_valid = rw->req_valid;
+	const unsigned int rq_calls = robwidget_size_request_calls;
+#endif
+
+	robwidget_size_request(self->tl, &nox, &noy);
 
 	if (!init && rw->size_limit) {
 		self->tl->size_limit(self->tl, &self->width, &self->height);
 		if (oldw != self->width || oldh != self->height) {
 			size_changed = TRUE;
+			/* the plugin re-scaled to fit the new size */
+			robwidget_size_reset(self->tl);
+			robwidget_size_request(self->tl, &nox, &noy);
+#ifdef DEBUG_RESIZE
+			tree_valid = false;
+#endif
 		}
 	} else if (setsize) {
 		if (oldw != nox || oldh != noy) {
@@ -530,22 +1202,119 @@ static void robwidget_layout(GlMetersLV2UI * const self, bool setsize, bool init
 				nox, self->width, noy, self->height);
 	}
 
-	if (rw->size_allocate) {
-		self->tl->size_allocate(rw, self->width, self->height);
+	if (rw->size_allocate) {
+		robwidget_size_allocate(rw, self->width, self->height);
+	}
+
+#ifdef DEBUG_RESIZE
+	if (tree_valid && rq_calls != robwidget_size_request_calls) {
+		fprintf(stderr, "robwidget_layout: %u size requests of an unchanged tree\n",
+				robwidget_size_request_calls - rq_calls);
+	}
+#endif
+
+	rtoplevel_cache(rw, TRUE);
+	rdisplay_list_build(&self->display_list, rw);
+	layers_queue_rebuild(self);
+	// containers may redraw beyond the exposed area after re-layout
+	self->dirty_full = true;
+
+	if (init) {
+		return;
+	}
+
+	if (setsize && size_changed) {
+		self->resize_in_progress = TRUE;
+		puglPostResize(self->view);
+	} else {
+		queue_draw_full(rw);
+	}
+}
+
+static bool robwidget_is_ancestor(RobWidget *rw, RobWidget *c) {
+	for (; c; c = c->parent) {
+		if (c == rw) return true;
+		if (c->parent == c) break;
 	}
+	return false;
+}
 
-	rtoplevel_cache(rw, TRUE);
+/* incremental layout after a size change of rw.
+ *
+ * Starting at rw, the size request is re-computed going up until
+ * a widget's request is unchanged. Re-allocating this subtree with
+ * its previous allocation results in the same size, so nothing
+ * outside of it moves. Only children whose area changed (and the
+ * one containing rw) are redrawn.
+ *
+ * returns false if the toplevel needs to be laid out.
+ */
+static bool robwidget_relayout(GlMetersLV2UI * const self, RobWidget *rw) {
+	if (!self->tl->alloc_valid) {
+		return false;
+	}
+	if (!robwidget_is_visible(rw)) {
+		return true; // robwidget_show() triggers a layout
+	}
 
-	if (init) {
-		return;
+	RobWidget *r = rw;
+	for (;;) {
+		if (r == self->tl || !r->parent || r->parent == r) {
+			return false;
+		}
+		if (r->size_allocate && !r->alloc_valid) {
+			return false; // not allocated by robwidget_size_allocate()
+		}
+		const cairo_rectangle_t old = r->area;
+		const int req_w = r->req_w;
+		const int req_h = r->req_h;
+		int w, h;
+		robwidget_size_request(r, &w, &h);
+		if (w == req_w && h == req_h) {
+			if (r->size_allocate) {
+				robwidget_size_allocate(r, r->alloc_w, r->alloc_h);
+			} else {
+				r->area.width = old.width;
+				r->area.height = old.height;
+			}
+			r->area.x = old.x;
+			r->area.y = old.y;
+			if (r->area.width == old.width && r->area.height == old.height) {
+				break;
+			}
+		}
+		r = r->parent;
 	}
 
-	if (setsize && size_changed) {
-		self->resize_in_progress = TRUE;
-		puglPostResize(self->view);
+#ifdef DEBUG_RESIZE
+	printf("robwidget_relayout(%s) at '%s'\n", ROBWIDGET_NAME(rw), ROBWIDGET_NAME(r));
+#endif
+
+	if (r == rw) {
+		rtoplevel_cache(r, r->cached_position);
+		queue_draw(r);
 	} else {
-		queue_draw_full(rw);
+		/* the root did not move, trel of its children is still the old position */
+		for (unsigned int i = 0; i < r->childcount; ++i) {
+			RobWidget *c = r->children[i];
+			if (c->hidden) continue;
+			cairo_rectangle_t prev = {c->trel.x - r->trel.x, c->trel.y - r->trel.y, c->trel.width, c->trel.height};
+			if (!robwidget_is_ancestor(c, rw)
+					&& prev.x == c->area.x && prev.y == c->area.y
+					&& prev.width == c->area.width && prev.height == c->area.height) {
+				continue;
+			}
+			rtoplevel_cache(c, r->cached_position);
+			queue_draw_area(r, prev.x, prev.y, prev.width, prev.height);
+			queue_draw_area(r, c->area.x, c->area.y, c->area.width, c->area.height);
+		}
+		rtk_hit_index_build(r);
+		/* clear the background of the root where children moved */
+		r->resized = TRUE;
 	}
+	rdisplay_list_build(&self->display_list, self->tl);
+	layers_queue_rebuild(self);
+	return true;
 }
 
 // called by a widget if size changes
@@ -558,6 +1327,10 @@ static void resize_self(RobWidget *rw) {
 #ifdef DEBUG_RESIZE
 	printf("resize_self(%s)\n", ROBWIDGET_NAME(rw));
 #endif
+	robwidget_size_changed(rw);
+	if (robwidget_relayout(self, rw)) {
+		return;
+	}
 	robwidget_layout(self, TRUE, FALSE);
 }
 
@@ -598,27 +1371,176 @@ static void myusleep(uint32_t usec) {
 #endif
 }
 
+#ifdef EVENT_DRIVEN_UI
+static int wakeup_fd_open(int fd[2]) {
+#ifdef __linux__
+	fd[0] = fd[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (fd[0] < 0) {
+		return -1;
+	}
+#else
+	if (pipe(fd)) {
+		return -1;
+	}
+	for (int i = 0; i < 2; ++i) {
+		fcntl(fd[i], F_SETFL, fcntl(fd[i], F_GETFL) | O_NONBLOCK);
+		fcntl(fd[i], F_SETFD, FD_CLOEXEC);
+	}
+#endif
+	return 0;
+}
+
+static void wakeup_fd_close(int fd[2]) {
+	close(fd[0]);
+	if (fd[1] != fd[0]) {
+		close(fd[1]);
+	}
+}
+
+static void wakeup_fd_signal(int fd) {
+	const uint64_t one = 1;
+#ifdef __linux__
+	if (write(fd, &one, sizeof(one)) < 0) { ; }
+#else
+	if (write(fd, &one, 1) < 0) { ; }
+#endif
+}
+
+static void wakeup_fd_drain(int fd) {
+	uint64_t buf[8];
+	while (read(fd, buf, sizeof(buf)) > 0) ;
+}
+
+#ifndef SHARED_UI_THREAD
+/* sleep until there are X11 events to process or a redraw is due */
+static void ui_wait(GlMetersLV2UI* self) {
+	const int xfd = puglGetEventFd(self->view);
+	if (xfd < 0) {
+		myusleep(1000000 / UI_MAX_FPS);
+		return;
+	}
+	if (puglHasPendingEvents(self->view)) {
+		return;
+	}
+	bool pending = puglIsRedisplayPending(self->view);
+
+	while (!self->exit) {
+		int timeout = -1;
+		if (pending) {
+			const uint64_t now = microtime(0);
+			if (now >= self->next_frame) {
+				return;
+			}
+			timeout = self->next_frame - now;
+		}
+
+		struct pollfd pfd[2];
+		pfd[0].fd = xfd;
+		pfd[0].events = POLLIN;
+		pfd[0].revents = 0;
+		pfd[1].fd = self->wakeup_fd[0];
+		pfd[1].events = POLLIN;
+		pfd[1].revents = 0;
+
+		const int rv = poll(pfd, 2, timeout);
+		if (rv < 0) {
+			if (errno == EINTR) continue;
+			myusleep(1000000 / UI_MAX_FPS);
+			return;
+		}
+		if (rv == 0) {
+			return; // next frame is due
+		}
+		if (pfd[1].revents) {
+			/* clear the flag first, a wakeup racing with the read is not lost */
+			__sync_lock_release(&self->wakeup_pending);
+			wakeup_fd_drain(self->wakeup_fd[0]);
+			pending = true;
+		}
+		if (pfd[0].revents) {
+			return; // handle input without delay
+		}
+	}
+}
+#endif
+#endif
+
+/* called from any thread, wake up GUI thread to process the change */
+static void ui_wakeup(GlMetersLV2UI* self) {
+#ifdef EVENT_DRIVEN_UI
+	if (__sync_lock_test_and_set(&self->wakeup_pending, 1)) {
+		return; // already signalled
+	}
+	wakeup_fd_signal(self->wakeup_fd[1]);
+#endif
+}
+
 /*****************************************************************************/
 
 static void reallocate_canvas(GlMetersLV2UI* self) {
-#ifdef DEBUG_RESIZE
-	printf("reallocate_canvas()\n");
-#endif
 	self->queue_canvas_realloc = false;
+	self->canvas_w = ceilf(self->width * self->canvas_scale);
+	self->canvas_h = ceilf(self->height * self->canvas_scale);
+
+	/* the cairo surface is only a view into the canvas memory */
 	if (self->cr) {
-		glDeleteTextures (1, &self->texture_id);
-		free (self->surf_data);
 		cairo_destroy (self->cr);
+		cairo_surface_destroy (self->surface);
+		self->cr = NULL;
+		self->surface = NULL;
+	}
+
+	const int cap_w = canvas_capacity(self->canvas_w, self->canvas_cap_w);
+	const int cap_h = canvas_capacity(self->canvas_h, self->canvas_cap_h);
+	const bool new_mem = !self->surf_data || cap_w != self->canvas_cap_w || cap_h != self->canvas_cap_h;
+#ifdef DEBUG_RESIZE
+	printf("reallocate_canvas() %dx%d capacity %dx%d%s\n",
+			self->canvas_w, self->canvas_h, cap_w, cap_h, new_mem ? " (new)" : "");
+#endif
+
+#ifdef PUGL_XSHM
+	if (new_mem) {
+		self->surf_data = xshm_alloc_canvas(self->view, cap_w, cap_h, &self->canvas_stride);
+	}
+#else
+	opengl_reset(self->canvas_w, self->canvas_h);
+	layers_rebuild(self);
+	if (new_mem) {
+		free (self->surf_data);
+		self->surf_data = opengl_alloc_canvas(cap_w, cap_h, &self->canvas_stride);
+		opengl_reallocate_texture(cap_w, cap_h, &self->texture_id);
+#ifdef USE_GL_PBO
+		if (self->use_pbo) {
+			opengl_reallocate_pbo(cap_w, cap_h, &self->pbo);
+		}
+#endif
+	}
+#endif
+	if (new_mem) {
+		self->canvas_cap_w = self->surf_data ? cap_w : 0;
+		self->canvas_cap_h = self->surf_data ? cap_h : 0;
+	}
+	if (!self->surf_data) {
+		return;
+	}
+	self->cr = canvas_create_cairo_t(self->canvas_w, self->canvas_h, self->canvas_stride, self->surf_data, &self->surface);
+	if (!self->cr) {
+		return;
 	}
-	opengl_reallocate_texture(self->width, self->height, &self->texture_id);
-	self->cr = opengl_create_cairo_t(self->width, self->height, &self->surface, &self->surf_data);
+
+	/* widgets are drawn in layout coordinates */
+	cairo_scale (self->cr, self->canvas_scale, self->canvas_scale);
+	self->dirty_full = true;
+	rtk_damage_clear(&self->dirty);
+#ifdef DEBUG_OVERDRAW
+	rtk_overdraw_alloc(&self->overdraw, self->canvas_w, self->canvas_h);
+#endif
 
 	/* clear top window */
 	cairo_save(self->cr);
 	cairo_set_source_rgba (self->cr, .0, .0, .0, 1.0);
 	cairo_set_operator (self->cr, CAIRO_OPERATOR_SOURCE);
-	cairo_rectangle (self->cr, 0, 0, self->width, self->height);
-	cairo_fill (self->cr);
+	cairo_paint (self->cr);
 	cairo_restore(self->cr);
 }
 
@@ -648,32 +1570,34 @@ onRealReshape(PuglView* view, int width, int height)
 			printf("onRealReshape post-layout %dx%d\n",
 					self->width, self->height);
 #endif
-			reallocate_canvas(self);
+			self->queue_canvas_realloc = true;
 			// fall-thru to scale
 		case LVGL_ZOOM_TO_ASPECT:
+			{
+	/* re-render at native resolution: the canvas is allocated at
+	 * window-size and the widget-tree drawn with a cairo scale */
+	float scale = 1.0;
+	if (self->width != width || self->height != height) {
+		scale = MIN(width / (float) self->width, height / (float) self->height);
+	}
+	if (scale != self->canvas_scale
+			|| ceilf(self->width * scale) != self->canvas_w
+			|| ceilf(self->height * scale) != self->canvas_h) {
+		self->canvas_scale = scale;
+		self->queue_canvas_realloc = true;
+	}
+			}
 			if (self->queue_canvas_realloc) {
 				reallocate_canvas(self);
 			}
 			rtoplevel_cache(self->tl, TRUE); // redraw background
-			if (self->width == width && self->height == height) {
-	self->xoff = 0; self->yoff = 0; self->xyscale = 1.0;
-	glViewport (0, 0, self->width, self->height);
-			} else
+			rdisplay_list_build(&self->display_list, self->tl);
+			self->dirty_full = true;
 			{
-	reallocate_canvas(self);
-	const float gl_aspect = width / (float) height;
-	const float cl_aspect = self->width / (float) self->height;
-	if (gl_aspect > cl_aspect) {
-		self->xyscale = (float) self->height / (float) height;
-		self->xoff = (width - self->width / self->xyscale)/2;
-		self->yoff = (height - self->height / self->xyscale)/2;
-	} else {
-		self->xoff = 0;
-		self->xyscale = (float) self->width / (float) width;
-		self->xoff = (width - self->width / self->xyscale)/2;
-		self->yoff = (height - self->height / self->xyscale)/2;
-	}
-	glViewport (self->xoff, self->yoff, self->width / self->xyscale, self->height / self->xyscale);
+	self->xyscale = 1.0 / self->canvas_scale;
+	self->xoff = (width - self->canvas_w) / 2;
+	self->yoff = (height - self->canvas_h) / 2;
+	opengl_viewport (self->xoff, self->yoff, self->canvas_w, self->canvas_h);
 			}
 			break;
 		case LVGL_CENTER:
@@ -681,21 +1605,23 @@ onRealReshape(PuglView* view, int width, int height)
 	self->xyscale = 1.0;
 	self->xoff = (width - self->width)/2;
 	self->yoff = (height - self->height)/2;
-	glViewport (self->xoff, self->yoff, self->width, self->height);
+	opengl_viewport (self->xoff, self->yoff, self->width, self->height);
 
 			}
 			break;
 		case LVGL_TOP_LEFT:
 			{
 	self->xoff = 0; self->yoff = 0; self->xyscale = 1.0;
-	glViewport (0, (height - self->height), self->width, self->height);
+	opengl_viewport (0, (height - self->height), self->width, self->height);
 			}
 			break;
 	}
 
+#ifndef PUGL_XSHM
 	glMatrixMode (GL_PROJECTION);
 	glLoadIdentity ();
 	glOrtho (-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
+#endif
 	queue_draw_full(self->tl);
 }
 
@@ -704,13 +1630,23 @@ onRealReshape(PuglView* view, int width, int height)
 
 static void onGlInit (PuglView *view) {
 	GlMetersLV2UI* self = (GlMetersLV2UI*)puglGetHandle(view);
+#ifdef PUGL_XSHM
+	reallocate_canvas(self);
+#else
 #ifdef DEBUG_UI
 	printf("OpenGL version: %s\n", glGetString (GL_VERSION));
 	printf("OpenGL vendor: %s\n", glGetString (GL_VENDOR));
 	printf("OpenGL renderer: %s\n", glGetString (GL_RENDERER));
 #endif
 	opengl_init();
+#ifdef USE_GL_PBO
+	self->use_pbo = opengl_have_pbo();
+#ifdef DEBUG_UI
+	printf("OpenGL pixel-buffer-object upload: %s\n", self->use_pbo ? "yes" : "no");
+#endif
+#endif
 	reallocate_canvas(self);
+#endif
 }
 
 static void onClose(PuglView* view) {
@@ -811,12 +1747,60 @@ static void onDisplay(PuglView* view) {
 		}
 	}
 #endif
-	if (self->resize_in_progress) { return; }
-	if (!self->cr) return; // XXX exit failure
+	if (self->resize_in_progress || !self->cr /* XXX exit failure */) {
+		puglSkipFrame(view);
+		return;
+	}
+
+	/* no damage, no present */
+	if (!canvas_has_damage(self) && !puglIsExposed(view)) {
+		puglSkipFrame(view);
+		++self->frames_skipped;
+		return;
+	}
 
+	const uint64_t t_frame = rtk_stats_time();
+#ifdef PUGL_XSHM
+	/* the server may still read the previous frame */
+	puglWaitImage(view);
+#endif
+#ifdef DEBUG_OVERDRAW
+	rtk_overdraw = &self->overdraw;
+	cairo_expose(self);
+	rtk_overdraw_report(&self->overdraw);
+	rtk_overdraw = NULL;
+#else
 	cairo_expose(self);
+#endif
+
+	uint64_t t0 = rtk_stats_time();
 	cairo_surface_flush(self->surface);
-	opengl_draw(self->width, self->height, self->surf_data, self->texture_id);
+	rtk_stats_since(&self->stats, RTK_STAT_FLUSH, t0);
+
+#ifdef PUGL_XSHM
+	if (puglIsExposed(view)) {
+		self->dirty_full = true;
+	}
+#endif
+	t0 = rtk_stats_time();
+	canvas_upload(self);
+#ifndef PUGL_XSHM
+	if (layers_need_rebuild(self)) {
+		layers_rebuild(self);
+	}
+	layers_update(self);
+#endif
+	rtk_stats_since(&self->stats, RTK_STAT_UPLOAD, t0);
+
+#ifndef PUGL_XSHM
+	t0 = rtk_stats_time();
+	opengl_draw(self->canvas_w, self->canvas_h, self->surf_data, self->texture_id);
+	layers_draw(self);
+	puglSwapBuffers(view);
+	rtk_stats_since(&self->stats, RTK_STAT_PRESENT, t0);
+#endif
+	rtk_stats_since(&self->stats, RTK_STAT_FRAME, t_frame);
+	++self->frames_presented;
 }
 
 #define GL_MOUSEBOUNDS \
@@ -958,15 +1942,41 @@ static void pugl_init(GlMetersLV2UI* self) {
 #endif
 
 	if (self->tl->size_default) {
+		const int oldw = self->width;
+		const int oldh = self->height;
 		self->tl->size_default(self->tl, &self->width, &self->height);
 		self->resize = NULL;
+		if (oldw != self->width || oldh != self->height) {
+			/* the plugin re-scaled to its default size */
+			robwidget_size_reset(self->tl);
+		}
 	}
 }
 
 void pugl_cleanup(GlMetersLV2UI* self) {
+#ifdef PUGL_XSHM
+	/* image data is owned by pugl */
+	if (self->cr) {
+		cairo_destroy (self->cr);
+		cairo_surface_destroy (self->surface);
+	}
+	puglDestroy(self->view);
+	return;
+#endif
 	glDeleteTextures (1, &self->texture_id); // XXX does his need glxContext ?!
+#ifndef PUGL_XSHM
+	layers_free(self);
+#endif
+#ifdef USE_GL_PBO
+	if (self->use_pbo) {
+		glDeleteBuffers (1, &self->pbo);
+	}
+#endif
+	if (self->cr) {
+		cairo_destroy (self->cr);
+		cairo_surface_destroy (self->surface);
+	}
 	free (self->surf_data);
-	cairo_destroy (self->cr);
 	puglDestroy(self->view);
 }
 
@@ -976,6 +1986,7 @@ void pugl_cleanup(GlMetersLV2UI* self) {
 static int process_gui_events(LV2UI_Handle handle) {
 	GlMetersLV2UI* self = (GlMetersLV2UI*)handle;
 	puglProcessEvents(self->view);
+	rtk_stats_poll(&self->stats, self->frames_presented, self->frames_skipped);
 	if (!self->gl_initialized) {
 		puglPostRedisplay(self->view);
 	}
@@ -1010,6 +2021,293 @@ static int idle(LV2UI_Handle handle) {
 	return 0;
 }
 
+/* one iteration of the GUI thread */
+static void ui_service(GlMetersLV2UI* self) {
+	if (self->ui_queue_puglXWindow > 0) {
+		puglShowWindow(self->view);
+		ui_enable(self->ui);
+		self->ui_queue_puglXWindow = 0;
+	}
+	process_gui_events(self);
+	if (self->ui_queue_puglXWindow < 0) {
+		ui_disable(self->ui);
+		puglHideWindow(self->view);
+		self->ui_queue_puglXWindow = 0;
+	}
+}
+
+#ifdef SHARED_UI_THREAD
+
+static pthread_mutex_t  sched_start_lock = PTHREAD_MUTEX_INITIALIZER; // thread start/stop
+static pthread_mutex_t  sched_lock = PTHREAD_MUTEX_INITIALIZER; // view list
+static pthread_cond_t   sched_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t        sched_thread;
+static bool             sched_running = false;
+static bool             sched_exit = false;
+static bool             sched_stopping = false; // exit requested by the thread itself
+static int              sched_wakeup_fd[2];
+static GlMetersLV2UI**  sched_views = NULL;
+static unsigned int     sched_count = 0;
+static unsigned int     sched_size = 0;
+
+static void gl_free(GlMetersLV2UI* self);
+
+/* views are serviced without holding sched_lock: plugin and host
+ * callbacks may (un)register views from the scheduler thread.
+ * A view closed that way is destroyed after ui_service() returned */
+static bool ui_sched_is_thread() {
+	return sched_running && pthread_equal(pthread_self(), sched_thread);
+}
+
+/* call with sched_lock held */
+static bool ui_sched_has_view(GlMetersLV2UI* self) {
+	for (unsigned int i = 0; i < sched_count; ++i) {
+		if (sched_views[i] == self) return !self->sched_remove;
+	}
+	return false;
+}
+
+/* call with sched_lock held */
+static void ui_sched_remove(unsigned int i) {
+	GlMetersLV2UI* self = sched_views[i];
+#ifdef INIT_PUGL_IN_THREAD
+	pugl_cleanup(self);
+#endif
+	memmove(&sched_views[i], &sched_views[i + 1], (sched_count - i - 1) * sizeof(GlMetersLV2UI*));
+	--sched_count;
+	self->sched_active = false;
+}
+
+static void* ui_sched_thread(void* arg) {
+	struct pollfd* pfd = NULL;
+	GlMetersLV2UI** run = NULL;
+	unsigned int   pfd_size = 0;
+	unsigned int   run_size = 0;
+	int timeout = 0;
+
+	pthread_mutex_lock (&sched_lock);
+	while (!sched_exit) {
+		/* views are only removed by this thread, new ones are appended */
+		const unsigned int n_polled = sched_count;
+		if (pfd_size < n_polled + 1) {
+			pfd_size = n_polled + 1;
+			pfd = (struct pollfd*) realloc(pfd, pfd_size * sizeof(struct pollfd));
+		}
+		pfd[0].fd = sched_wakeup_fd[0];
+		pfd[0].events = POLLIN;
+		pfd[0].revents = 0;
+		for (unsigned int i = 0; i < n_polled; ++i) {
+			pfd[i + 1].fd = sched_views[i]->view ? puglGetEventFd(sched_views[i]->view) : -1;
+			pfd[i + 1].events = POLLIN;
+			pfd[i + 1].revents = 0;
+		}
+		pthread_mutex_unlock (&sched_lock);
+
+		if (poll(pfd, n_polled + 1, timeout) > 0 && pfd[0].revents) {
+			wakeup_fd_drain(sched_wakeup_fd[0]);
+		}
+
+		pthread_mutex_lock (&sched_lock);
+		for (unsigned int i = 0; i < sched_count; ++i) {
+			sched_views[i]->sched_xready = i < n_polled && pfd[i + 1].revents;
+		}
+
+		if (run_size < sched_count) {
+			run_size = sched_size;
+			run = (GlMetersLV2UI**) realloc(run, run_size * sizeof(GlMetersLV2UI*));
+		}
+
+		const uint64_t now = microtime(0);
+		bool changed = false;
+		unsigned int n_run = 0;
+
+		for (unsigned int i = 0; i < sched_count;) {
+			GlMetersLV2UI* self = sched_views[i];
+
+			if (self->sched_remove) {
+				ui_sched_remove(i);
+				changed = true;
+				if (self->sched_deferred) {
+					pthread_mutex_unlock (&sched_lock);
+					gl_free(self);
+					pthread_mutex_lock (&sched_lock);
+					if (sched_count == 0) {
+						/* joined when the next view registers */
+						sched_exit = true;
+						sched_stopping = true;
+					}
+				}
+				continue;
+			}
+			++i;
+
+#ifdef INIT_PUGL_IN_THREAD
+			if (!self->ui_initialized) {
+				pugl_init(self);
+				self->ui_initialized = TRUE;
+				changed = true;
+			}
+#endif
+			__sync_lock_release(&self->wakeup_pending);
+
+			if (self->sched_xready
+					|| self->ui_queue_puglXWindow != 0
+					|| puglHasPendingEvents(self->view)
+					|| (puglIsRedisplayPending(self->view) && now >= self->next_frame)
+				 ) {
+				self->next_frame = now + 1000 / UI_MAX_FPS;
+				run[n_run++] = self;
+			}
+		}
+		if (changed) {
+			pthread_cond_broadcast (&sched_cond);
+		}
+
+		for (unsigned int i = 0; i < n_run; ++i) {
+			/* a callback may have removed it */
+			if (!ui_sched_has_view(run[i])) continue;
+			pthread_mutex_unlock (&sched_lock);
+			ui_service(run[i]);
+			pthread_mutex_lock (&sched_lock);
+		}
+
+		timeout = -1;
+		for (unsigned int i = 0; i < sched_count; ++i) {
+			GlMetersLV2UI* self = sched_views[i];
+			if (self->sched_remove) {
+				timeout = 0;
+			} else if (puglIsRedisplayPending(self->view)) {
+				const int dt = self->next_frame > now ? self->next_frame - now : 0;
+				if (timeout < 0 || dt < timeout) {
+					timeout = dt;
+				}
+			}
+		}
+	}
+	pthread_mutex_unlock (&sched_lock);
+	free(pfd);
+	free(run);
+	return NULL;
+}
+
+/* call with sched_start_lock held */
+static void ui_sched_stop() {
+	pthread_join(sched_thread, NULL);
+	wakeup_fd_close(sched_wakeup_fd);
+	free(sched_views);
+	sched_views = NULL;
+	sched_size = 0;
+	sched_running = false;
+	sched_stopping = false;
+}
+
+/* from the scheduler thread itself (a plugin or host callback) only
+ * sched_lock is taken: a thread holding sched_start_lock may be
+ * waiting for the scheduler, and the thread cannot be started or
+ * stopped concurrently with itself */
+static int ui_sched_register(GlMetersLV2UI* self) {
+	const bool in_thread = ui_sched_is_thread();
+	if (!in_thread) {
+		pthread_mutex_lock (&sched_start_lock);
+		pthread_mutex_lock (&sched_lock);
+		const bool stopping = sched_stopping;
+		pthread_mutex_unlock (&sched_lock);
+		if (stopping) {
+			ui_sched_stop();
+		}
+		if (!sched_running) {
+			if (wakeup_fd_open(sched_wakeup_fd)) {
+				pthread_mutex_unlock (&sched_start_lock);
+				return -1;
+			}
+			sched_exit = false;
+			pthread_create(&sched_thread, NULL, ui_sched_thread, NULL);
+			sched_running = true;
+		}
+	}
+
+	pthread_mutex_lock (&sched_lock);
+	if (in_thread && sched_stopping) {
+		/* last view was removed by a callback, keep running */
+		sched_exit = false;
+		sched_stopping = false;
+	}
+	if (sched_count >= sched_size) {
+		sched_size = sched_size ? sched_size * 2 : 8;
+		sched_views = (GlMetersLV2UI**) realloc(sched_views, sched_size * sizeof(GlMetersLV2UI*));
+	}
+	self->wakeup_fd[0] = sched_wakeup_fd[0];
+	self->wakeup_fd[1] = sched_wakeup_fd[1];
+	self->sched_remove = false;
+	self->sched_deferred = false;
+	self->sched_active = true;
+	self->next_frame = 0;
+#ifdef INIT_PUGL_IN_THREAD
+	if (in_thread) {
+		pugl_init(self);
+		self->ui_initialized = TRUE;
+	}
+#endif
+	sched_views[sched_count++] = self;
+	pthread_mutex_unlock (&sched_lock);
+
+	wakeup_fd_signal(sched_wakeup_fd[1]);
+
+	if (in_thread) {
+		return 0;
+	}
+
+#ifdef INIT_PUGL_IN_THREAD
+	pthread_mutex_lock (&sched_lock);
+	while (!self->ui_initialized) {
+		pthread_cond_wait (&sched_cond, &sched_lock);
+	}
+	pthread_mutex_unlock (&sched_lock);
+#endif
+	pthread_mutex_unlock (&sched_start_lock);
+	return 0;
+}
+
+/* returns true if the view is still in use, the scheduler
+ * thread then frees it (see ui_sched_thread) */
+static bool ui_sched_unregister(GlMetersLV2UI* self) {
+	pthread_mutex_lock (&sched_lock);
+	if (ui_sched_is_thread()) {
+		/* called back from ui_service(), the view's event
+		 * processing may still be on the stack */
+		self->sched_remove = true;
+		self->sched_deferred = true;
+		pthread_mutex_unlock (&sched_lock);
+		return true;
+	}
+
+	/* wait without sched_start_lock, callbacks of other views
+	 * may (un)register while the thread handles this one */
+	self->sched_remove = true;
+	wakeup_fd_signal(sched_wakeup_fd[1]);
+	while (self->sched_active) {
+		pthread_cond_wait (&sched_cond, &sched_lock);
+	}
+	pthread_mutex_unlock (&sched_lock);
+
+	pthread_mutex_lock (&sched_start_lock);
+	pthread_mutex_lock (&sched_lock);
+	const bool stop = sched_running && sched_count == 0 && !sched_stopping;
+	if (stop) {
+		sched_exit = true;
+	}
+	pthread_mutex_unlock (&sched_lock);
+
+	if (stop) {
+		wakeup_fd_signal(sched_wakeup_fd[1]);
+		ui_sched_stop();
+	}
+	pthread_mutex_unlock (&sched_start_lock);
+	return false;
+}
+
+#else
+
 static void* ui_thread(void* handle) {
 	GlMetersLV2UI* self = (GlMetersLV2UI*)handle;
 #ifdef THREADSYNC
@@ -1021,17 +2319,7 @@ static void* ui_thread(void* handle) {
 #endif
 
 	while (!self->exit) {
-		if (self->ui_queue_puglXWindow > 0) {
-			puglShowWindow(self->view);
-			ui_enable(self->ui);
-			self->ui_queue_puglXWindow = 0;
-		}
-		process_gui_events(self);
-		if (self->ui_queue_puglXWindow < 0) {
-			ui_disable(self->ui);
-			puglHideWindow(self->view);
-			self->ui_queue_puglXWindow = 0;
-		}
+		ui_service(self);
 #ifdef THREADSYNC
 		//myusleep(1000000 / 60); // max FPS
 		struct timespec now;
@@ -1043,6 +2331,9 @@ static void* ui_thread(void* handle) {
 		}
 		assert(now.tv_nsec >= 0 && now.tv_nsec < 1000000000);
 		pthread_cond_timedwait (&self->data_ready, &self->msg_thread_lock, &now);
+#elif defined EVENT_DRIVEN_UI
+		self->next_frame = microtime(1.f / UI_MAX_FPS);
+		ui_wait(self);
 #else
 		myusleep(1000000 / 50); // FPS
 #endif
@@ -1055,7 +2346,8 @@ static void* ui_thread(void* handle) {
 #endif
 	return NULL;
 }
-#endif
+#endif // SHARED_UI_THREAD
+#endif // USE_GUI_THREAD
 
 
 /******************************************************************************
@@ -1120,7 +2412,15 @@ gl_instantiate(const LV2UI_Descriptor*   descriptor,
 
 	self->ui_closed = NULL;
 	self->close_ui = FALSE;
-	self->rb = posrb_alloc(sizeof(RWArea) * 48); // depends on plugin and threading stategy
+	self->rb_retired_cnt = 0;
+	self->rb_overflow = 0;
+	self->rb = rtk_ring_alloc(sizeof(RobWidget*), FASTTRACK_MIN); // resized below
+	if (!self->rb || rtk_damage_queue_init(&self->damage_queue)) {
+		fprintf(stderr, "meters.lv2: out of memory.\n");
+		fasttrack_free(self);
+		free(self);
+		return NULL;
+	}
 
 	self->tl = NULL;
 	self->ui = instantiate(self,
@@ -1128,7 +2428,8 @@ gl_instantiate(const LV2UI_Descriptor*   descriptor,
 			write_function, controller, &self->tl, features);
 
 	if (!self->ui) {
-		posrb_free(self->rb);
+		fasttrack_free(self);
+		rtk_damage_queue_free(&self->damage_queue);
 		free(self);
 #ifdef DEBUG_UI
 		fprintf(stderr, "error: ui object not returned by instantiate.\n");
@@ -1136,7 +2437,8 @@ gl_instantiate(const LV2UI_Descriptor*   descriptor,
 		return NULL;
 	}
 	if (!self->tl || !self->tl->expose_event || !self->tl->size_request) {
-		posrb_free(self->rb);
+		fasttrack_free(self);
+		rtk_damage_queue_free(&self->damage_queue);
 		free(self);
 #ifdef DEBUG_UI
 		if (!self->tl) {
@@ -1150,6 +2452,23 @@ gl_instantiate(const LV2UI_Descriptor*   descriptor,
 		return NULL;
 	}
 
+	rtk_stats_init(&self->stats, plugin_uri);
+
+	/* size the fast-track queue for this UI, nothing is queued before the view exists */
+#ifdef LVGL_FASTTRACK_QUEUE
+	const uint32_t ft_size = LVGL_FASTTRACK_QUEUE;
+#else
+	const uint32_t ft_size = MIN(FASTTRACK_MAX, fasttrack_widget_count(self->tl));
+#endif
+	if (ft_size > rtk_ring_capacity(self->rb)) {
+		RtkRing *rb = rtk_ring_alloc(sizeof(RobWidget*), ft_size);
+		if (rb) {
+			rtk_ring_free(self->rb);
+			self->rb = rb;
+		}
+	}
+	self->stats.rb_capacity = rtk_ring_capacity(self->rb);
+
 	robwidget_layout(self, TRUE, TRUE);
 
 	assert(self->width > 0 && self->height > 0);
@@ -1158,12 +2477,26 @@ gl_instantiate(const LV2UI_Descriptor*   descriptor,
 	self->surface= NULL; // not really needed, but hey
 	self->surf_data = NULL; // ditto
 	self->texture_id = 0; // already too much of this to keep valgrind happy
+#ifndef PUGL_XSHM
+	self->layers = NULL;
+	self->layer_cnt = 0;
+#endif
+#ifdef USE_GL_PBO
+	self->use_pbo = false;
+	self->pbo = 0;
+#endif
+	rtk_damage_clear(&self->dirty);
+	self->dirty_full = true;
+	self->frames_presented = 0;
+	self->frames_skipped = 0;
 	self->xoff = self->yoff = 0; self->xyscale = 1.0;
+	self->canvas_scale = 1.0;
+	self->canvas_w = self->width;
+	self->canvas_h = self->height;
+	self->canvas_cap_w = self->canvas_cap_h = 0;
+	self->canvas_stride = 0;
 	self->gl_initialized   = 0;
-	self->expose_area.x = 0;
-	self->expose_area.y = 0;
-	self->expose_area.width = self->width;
-	self->expose_area.height = self->height;
+	rtk_damage_full(&self->expose_area, self->width, self->height);
 	self->mousefocus = NULL;
 	self->mousehover = NULL;
 	self->resize_in_progress = FALSE;
@@ -1182,6 +2515,24 @@ gl_instantiate(const LV2UI_Descriptor*   descriptor,
 	self->do_the_funky_resize = FALSE;
 #endif
 
+#ifdef EVENT_DRIVEN_UI
+	self->wakeup_pending = 0;
+	self->next_frame = 0;
+#ifdef SHARED_UI_THREAD
+	self->wakeup_fd[0] = self->wakeup_fd[1] = -1; // assigned when registering
+#else
+	if (wakeup_fd_open(self->wakeup_fd)) {
+		fprintf (stderr, "meters.lv2: cannot create wakeup fd.\n");
+		cleanup(self->ui);
+		fasttrack_free(self);
+		rtk_damage_queue_free(&self->damage_queue);
+		rtk_stats_free(&self->stats);
+		free(self);
+		return NULL;
+	}
+#endif
+#endif
+
 #if (!defined USE_GUI_THREAD) || (!defined INIT_PUGL_IN_THREAD)
 	pugl_init(self);
 #endif
@@ -1189,6 +2540,20 @@ gl_instantiate(const LV2UI_Descriptor*   descriptor,
 #ifdef USE_GUI_THREAD
 	self->ui_queue_puglXWindow = 0;
 	self->exit = false;
+#ifdef SHARED_UI_THREAD
+	if (ui_sched_register(self)) {
+		fprintf (stderr, "meters.lv2: cannot start GUI thread.\n");
+#ifndef INIT_PUGL_IN_THREAD
+		pugl_cleanup(self);
+#endif
+		cleanup(self->ui);
+		fasttrack_free(self);
+		rtk_damage_queue_free(&self->damage_queue);
+		rtk_stats_free(&self->stats);
+		free(self);
+		return NULL;
+	}
+#else
 	pthread_create(&self->thread, NULL, ui_thread, self);
 #ifdef INIT_PUGL_IN_THREAD
 	while (!self->ui_initialized) {
@@ -1197,6 +2562,7 @@ gl_instantiate(const LV2UI_Descriptor*   descriptor,
 	}
 #endif
 #endif
+#endif
 
 
 #ifdef XTERNAL_UI
@@ -1221,11 +2587,11 @@ gl_instantiate(const LV2UI_Descriptor*   descriptor,
 	return self;
 }
 
-static void gl_cleanup(LV2UI_Handle handle) {
-	GlMetersLV2UI* self = (GlMetersLV2UI*)handle;
-#ifdef USE_GUI_THREAD
-	self->exit = true;
-	pthread_join(self->thread, NULL);
+/* after the GUI thread stopped servicing the view */
+static void gl_free(GlMetersLV2UI* self) {
+	rtk_stats_dump(&self->stats, self->frames_presented, self->frames_skipped);
+#ifdef PROFILE_EXPOSE
+	rtk_profile_dump(self->tl);
 #endif
 #if (!defined USE_GUI_THREAD) || (!defined INIT_PUGL_IN_THREAD)
 	pugl_cleanup(self);
@@ -1233,12 +2599,41 @@ static void gl_cleanup(LV2UI_Handle handle) {
 #if (defined USE_GUI_THREAD && defined THREADSYNC)
 	pthread_mutex_destroy(&self->msg_thread_lock);
 	pthread_cond_destroy(&self->data_ready);
+#endif
+#if (defined EVENT_DRIVEN_UI && !defined SHARED_UI_THREAD)
+	wakeup_fd_close(self->wakeup_fd);
 #endif
 	cleanup(self->ui);
-	posrb_free(self->rb);
+	fasttrack_free(self);
+	rtk_damage_queue_free(&self->damage_queue);
+	rdisplay_list_free(&self->display_list);
+#ifdef DEBUG_OVERDRAW
+	rtk_overdraw_free(&self->overdraw);
+#endif
+	rtk_stats_free(&self->stats);
 	free(self);
 }
 
+static void gl_cleanup(LV2UI_Handle handle) {
+	GlMetersLV2UI* self = (GlMetersLV2UI*)handle;
+#ifdef DEBUG_UI
+	printf("gl_cleanup: frames presented: %lu skipped: %lu\n",
+			(unsigned long) self->frames_presented, (unsigned long) self->frames_skipped);
+#endif
+#ifdef USE_GUI_THREAD
+	self->exit = true;
+#ifdef SHARED_UI_THREAD
+	if (self->sched_active && ui_sched_unregister(self)) {
+		return;
+	}
+#else
+	ui_wakeup(self);
+	pthread_join(self->thread, NULL);
+#endif
+#endif
+	gl_free(self);
+}
+
 static void
 gl_port_event(LV2UI_Handle handle,
            uint32_t     port_index,
@@ -1251,6 +2646,7 @@ gl_port_event(LV2UI_Handle handle,
 	 */
 	GlMetersLV2UI* self = (GlMetersLV2UI*)handle;
 	port_event(self->ui, port_index, buffer_size, format, buffer);
+	ui_wakeup(self);
 #if (defined USE_GUI_THREAD && defined THREADSYNC)
 	if (pthread_mutex_trylock (&self->msg_thread_lock) == 0) {
 		pthread_cond_signal (&self->data_ready);
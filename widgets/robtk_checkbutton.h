@@ -47,6 +47,8 @@ typedef struct {
 	cairo_pattern_t* btn_led;
 	cairo_surface_t* sf_txt_normal;
 	cairo_surface_t* sf_txt_enabled;
+	float sf_scale;
+	char *txt;
 
 	float w_width, w_height, l_width, l_height;
 	float c_on[4];
@@ -89,27 +91,29 @@ static void create_cbtn_pattern(RobTkCBtn * d) {
 	cairo_pattern_add_color_stop_rgba (d->btn_led, 1.0, 1.0, 1.0, 1.0, 0.7);
 }
 
-static void create_cbtn_text_surface(RobTkCBtn * d, const char * txt, PangoFontDescription *font) {
+static void create_cbtn_text_surface(RobTkCBtn * d) {
 	float c_col[4];
 	get_color_from_theme(0, c_col);
+	PangoFontDescription *font = get_font_from_theme();
 
-	create_text_surface(&d->sf_txt_normal,
+	create_text_surface_scaled(&d->sf_txt_normal,
 			d->w_width, d->w_height,
 			1 +
 			(d->w_width - (d->show_led ? GBT_LED_RADIUS + 6 : 0)) / 2.0
 			 + (d->show_led < 0 ? GBT_LED_RADIUS + 6 : 0),
 			d->w_height / 2.0 + 1,
-			txt, font, c_col);
+			d->txt, font, c_col, d->sf_scale);
 
 	get_color_from_theme(2, c_col);
 
-	create_text_surface(&d->sf_txt_enabled,
+	create_text_surface_scaled(&d->sf_txt_enabled,
 			d->w_width, d->w_height,
 			1 +
 			(d->w_width - (d->show_led ? GBT_LED_RADIUS + 6 : 0)) / 2.0
 			 + (d->show_led < 0 ? GBT_LED_RADIUS + 6 : 0),
 			d->w_height / 2.0 + 1,
-			txt, font, c_col);
+			d->txt, font, c_col, d->sf_scale);
+	pango_font_description_free(font);
 }
 
 
@@ -171,19 +175,24 @@ static bool robtk_cbtn_expose_event(RobWidget* handle, cairo_t* cr, cairo_rectan
 		cairo_fill(cr);
 	}
 
+	const float sf_scale = rtk_cache_scale(cr);
+	if (sf_scale != d->sf_scale) {
+		d->sf_scale = sf_scale;
+		create_cbtn_text_surface(d);
+	}
 	const float xalign = rint((d->w_width - d->l_width) * d->rw->xalign);
 	const float yalign = rint((d->w_height - d->l_height) * d->rw->yalign);
 
 	if (d->flat_button && !d->sensitive) {
 		//cairo_set_operator (cr, CAIRO_OPERATOR_XOR); // check
 		cairo_set_operator (cr, CAIRO_OPERATOR_EXCLUSION);
-		cairo_set_source_surface(cr, d->sf_txt_normal, xalign, yalign);
+		rtk_set_source_cache(cr, d->sf_txt_normal, xalign, yalign, d->sf_scale);
 	} else if (!d->flat_button && d->enabled) {
 		cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
-		cairo_set_source_surface(cr, d->sf_txt_enabled, xalign, yalign);
+		rtk_set_source_cache(cr, d->sf_txt_enabled, xalign, yalign, d->sf_scale);
 	} else {
 		cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
-		cairo_set_source_surface(cr, d->sf_txt_normal, xalign, yalign);
+		rtk_set_source_cache(cr, d->sf_txt_normal, xalign, yalign, d->sf_scale);
 	}
 	cairo_paint (cr);
 
@@ -298,6 +307,8 @@ static RobTkCBtn * robtk_cbtn_new(const char * txt, enum GedLedMode led, bool fl
 	d->handle = NULL;
 	d->sf_txt_normal = NULL;
 	d->sf_txt_enabled = NULL;
+	d->sf_scale = 1.0;
+	d->txt = strdup(txt);
 	d->btn_enabled = NULL;
 	d->btn_inactive = NULL;
 	d->sensitive = TRUE;
@@ -322,8 +333,8 @@ static RobTkCBtn * robtk_cbtn_new(const char * txt, enum GedLedMode led, bool fl
 	d->l_width = d->w_width;
 	d->l_height = d->w_height;
 
-	create_cbtn_text_surface(d, txt, fd);
 	pango_font_description_free(fd);
+	create_cbtn_text_surface(d);
 
 	d->rw = robwidget_new(d);
 	robwidget_set_alignment(d->rw, 0, .5);
@@ -348,6 +359,7 @@ static void robtk_cbtn_destroy(RobTkCBtn *d) {
 	cairo_pattern_destroy(d->btn_led);
 	cairo_surface_destroy(d->sf_txt_normal);
 	cairo_surface_destroy(d->sf_txt_enabled);
+	free(d->txt);
 	free(d);
 }
 
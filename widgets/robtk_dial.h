@@ -63,6 +63,7 @@ typedef struct _RobTkDial {
 
 	cairo_pattern_t* dpat;
 	cairo_surface_t* bg;
+	float dpat_scale;
 
 	float w_width, w_height;
 	float w_cx, w_cy;
@@ -72,8 +73,16 @@ typedef struct _RobTkDial {
 
 } RobTkDial;
 
+static void create_dial_pattern(RobTkDial * d);
+
 static bool robtk_dial_expose_event (RobWidget* handle, cairo_t* cr, cairo_rectangle_t* ev) {
 	RobTkDial * d = (RobTkDial *)GET_HANDLE(handle);
+	const float dpat_scale = rtk_cache_scale(cr);
+	if (dpat_scale != d->dpat_scale) {
+		d->dpat_scale = dpat_scale;
+		cairo_pattern_destroy(d->dpat);
+		create_dial_pattern(d);
+	}
 	cairo_rectangle (cr, ev->x, ev->y, ev->width, ev->height);
 	cairo_clip (cr);
 
@@ -369,8 +378,7 @@ static void create_dial_pattern(RobTkDial * d) {
 
 		cairo_surface_t* surface;
 		cairo_t* tc = 0;
-		surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, d->w_width, d->w_height);
-		tc = cairo_create (surface);
+		surface = rtk_cache_surface_create(d->w_width, d->w_height, d->dpat_scale, &tc);
 		cairo_set_operator (tc, CAIRO_OPERATOR_SOURCE);
 		cairo_set_source (tc, pat);
 		cairo_rectangle (tc, 0, 0, d->w_width, d->w_height);
@@ -384,6 +392,11 @@ static void create_dial_pattern(RobTkDial * d) {
 		cairo_pattern_destroy (shade_pattern);
 
 		pat = cairo_pattern_create_for_surface (surface);
+		if (d->dpat_scale != 1.0) {
+			cairo_matrix_t m;
+			cairo_matrix_init_scale(&m, d->dpat_scale, d->dpat_scale);
+			cairo_pattern_set_matrix(pat, &m);
+		}
 		cairo_destroy (tc);
 		cairo_surface_destroy (surface);
 	}
@@ -429,6 +442,7 @@ static RobTkDial * robtk_dial_new_with_size(float min, float max, float step,
 	d->rw = robwidget_new(d);
 	ROBWIDGET_SETNAME(d->rw, "dial");
 	robwidget_set_expose_event(d->rw, robtk_dial_expose_event);
+	robwidget_set_opaque(d->rw, TRUE);
 	robwidget_set_size_request(d->rw, robtk_dial_size_request);
 	robwidget_set_mouseup(d->rw, robtk_dial_mouseup);
 	robwidget_set_mousedown(d->rw, robtk_dial_mousedown);
@@ -461,6 +475,7 @@ static RobTkDial * robtk_dial_new_with_size(float min, float max, float step,
 	d->scroll_accel_thresh = 0;
 	rtk_clock_gettime(&d->scroll_accel_timeout);
 	d->bg  = NULL;
+	d->dpat_scale = 1.0;
 	create_dial_pattern(d);
 	d->scol = (float*) malloc(3 * 4 * sizeof(float));
 	d->scol[0*4] = 1.0; d->scol[0*4+1] = 0.0; d->scol[0*4+2] = 0.0; d->scol[0*4+3] = 0.2;
@@ -25,6 +25,7 @@ typedef struct {
 
 	bool sensitive;
 	cairo_surface_t* sf_txt;
+	float sf_scale;
 	float w_width, w_height;
 	float min_width;
 	float min_height;
@@ -34,26 +35,44 @@ typedef struct {
 	pthread_mutex_t _mutex;
 } RobTkLbl;
 
+static void priv_lbl_render_text(RobTkLbl *d) {
+	// _mutex must be held to call this function
+	PangoFontDescription *fd = get_font_from_theme();
+	create_text_surface_scaled(&d->sf_txt,
+			d->w_width, d->w_height,
+			d->w_width / 2.0 + 1,
+			d->w_height / 2.0 + 1,
+			d->txt, fd, d->fg, d->sf_scale);
+	pango_font_description_free(fd);
+}
+
 static bool robtk_lbl_expose_event(RobWidget* handle, cairo_t* cr, cairo_rectangle_t* ev) {
 	RobTkLbl* d = (RobTkLbl *)GET_HANDLE(handle);
 
+	/* opaque: paint the background, even if the text is busy */
+	cairo_rectangle (cr, ev->x, ev->y, ev->width, ev->height);
+	cairo_clip (cr);
+	cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+	cairo_set_source_rgb (cr, d->bg[0], d->bg[1], d->bg[2]);
+	cairo_paint (cr);
+
 	if (pthread_mutex_trylock (&d->_mutex)) {
 		queue_draw(d->rw);
 		return TRUE;
 	}
 
-	cairo_rectangle (cr, ev->x, ev->y, ev->width, ev->height);
-	cairo_clip (cr);
-	cairo_set_source_rgb (cr, d->bg[0], d->bg[1], d->bg[2]);
-	cairo_rectangle (cr, 0, 0, d->w_width, d->w_height);
-	cairo_fill(cr);
+	const float sf_scale = rtk_cache_scale(cr);
+	if (sf_scale != d->sf_scale) {
+		d->sf_scale = sf_scale;
+		priv_lbl_render_text(d);
+	}
 
 	if (d->sensitive) {
 		cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
 	} else {
 		cairo_set_operator (cr, CAIRO_OPERATOR_EXCLUSION);
 	}
-	cairo_set_source_surface(cr, d->sf_txt, 0, 0);
+	rtk_set_source_cache(cr, d->sf_txt, 0, 0, d->sf_scale);
 	cairo_paint (cr);
 
 	pthread_mutex_unlock (&d->_mutex);
@@ -64,6 +83,10 @@ static void priv_lbl_prepare_text(RobTkLbl *d, const char *txt) {
 	// _mutex must be held to call this function
 	int ww, wh;
 	PangoFontDescription *fd = get_font_from_theme();
+#ifndef GTK_BACKEND
+	const float old_w = d->w_width;
+	const float old_h = d->w_height;
+#endif
 
 	get_text_geometry(txt, fd, &ww, &wh);
 
@@ -81,16 +104,19 @@ static void priv_lbl_prepare_text(RobTkLbl *d, const char *txt) {
 	robwidget_show(d->rw, true);
 #endif
 
-	create_text_surface(&d->sf_txt,
-			d->w_width, d->w_height,
-			d->w_width / 2.0 + 1,
-			d->w_height / 2.0 + 1,
-			txt, fd, d->fg);
-
 	pango_font_description_free(fd);
 
+	priv_lbl_render_text(d);
+
+#ifdef GTK_BACKEND
 	robwidget_set_size(d->rw, d->w_width, d->w_height);
-	// TODO trigger re-layout  resize_self()
+#else
+	if (old_w != d->w_width || old_h != d->w_height) {
+		robwidget_set_size(d->rw, d->w_width, d->w_height);
+		robwidget_size_changed(d->rw);
+		resize_self(d->rw); // incremental, see robwidget_relayout()
+	}
+#endif
 
 	queue_draw(d->rw);
 }
@@ -124,6 +150,7 @@ static RobTkLbl * robtk_lbl_new(const char * txt) {
 	RobTkLbl *d = (RobTkLbl *) malloc(sizeof(RobTkLbl));
 
 	d->sf_txt = NULL;
+	d->sf_scale = 1.0;
 	d->min_width = d->w_width = 0;
 	d->min_height = d->w_height = 0;
 	d->txt = NULL;
@@ -132,6 +159,7 @@ static RobTkLbl * robtk_lbl_new(const char * txt) {
 	d->rw = robwidget_new(d);
 	ROBWIDGET_SETNAME(d->rw, "label");
 	robwidget_set_expose_event(d->rw, robtk_lbl_expose_event);
+	robwidget_set_opaque(d->rw, TRUE);
 	robwidget_set_size_request(d->rw, priv_lbl_size_request);
 
 	get_color_from_theme(1, d->bg);
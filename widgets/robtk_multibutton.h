@@ -250,6 +250,7 @@ static RobTkMBtn * robtk_mbtn_new(int modes) {
 
 	robwidget_set_size_request(d->rw, priv_mbtn_size_request);
 	robwidget_set_expose_event(d->rw, robtk_mbtn_expose_event);
+	robwidget_set_opaque(d->rw, TRUE);
 	robwidget_set_mouseup(d->rw, robtk_mbtn_mouseup);
 	robwidget_set_enter_notify(d->rw, robtk_mbtn_enter_notify);
 	robwidget_set_leave_notify(d->rw, robtk_mbtn_leave_notify);
@@ -37,11 +37,15 @@ typedef struct {
 	cairo_pattern_t* btn_active;
 	cairo_pattern_t* btn_inactive;
 	cairo_surface_t* sf_txt;
+	float sf_scale;
+	char *txt;
 
 	float w_width, w_height, l_width, l_height;
 
 } RobTkPBtn;
 
+static void create_pbtn_text_surface(RobTkPBtn * d);
+
 static bool robtk_pbtn_expose_event(RobWidget* handle, cairo_t* cr, cairo_rectangle_t* ev) {
 	RobTkPBtn * d = (RobTkPBtn *)GET_HANDLE(handle);
 	cairo_rectangle (cr, ev->x, ev->y, ev->width, ev->height);
@@ -71,9 +75,14 @@ static bool robtk_pbtn_expose_event(RobWidget* handle, cairo_t* cr, cairo_rectan
 	} else {
 		cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
 	}
+	const float sf_scale = rtk_cache_scale(cr);
+	if (sf_scale != d->sf_scale) {
+		d->sf_scale = sf_scale;
+		create_pbtn_text_surface(d);
+	}
 	const float xalign = rint((d->w_width - d->l_width) * d->rw->xalign);
 	const float yalign = rint((d->w_height - d->l_height) * d->rw->yalign);
-	cairo_set_source_surface(cr, d->sf_txt, xalign, yalign);
+	rtk_set_source_cache(cr, d->sf_txt, xalign, yalign, d->sf_scale);
 	cairo_paint (cr);
 
 	if (d->sensitive && d->prelight) {
@@ -147,12 +156,12 @@ static void create_pbtn_pattern(RobTkPBtn * d) {
 	cairo_pattern_add_color_stop_rgb (d->btn_active, ISBRIGHT(c_bg) ? 0.0 : 1.0, SHADE_RGB(c_bg, 2.4));
 }
 
-static void create_pbtn_text_surface(RobTkPBtn * d, const char * txt, PangoFontDescription *font) {
+static void create_pbtn_text_surface(RobTkPBtn * d) {
 	if (d->sf_txt) {
 		cairo_surface_destroy(d->sf_txt);
 	}
-	d->sf_txt = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, d->w_width, d->w_height);
-	cairo_t *cr = cairo_create (d->sf_txt);
+	cairo_t *cr;
+	d->sf_txt = rtk_cache_surface_create(d->w_width, d->w_height, d->sf_scale, &cr);
 	cairo_set_source_rgba (cr, .0, .0, .0, 0);
 	cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
 	cairo_rectangle (cr, 0, 0, d->w_width, d->w_height);
@@ -161,9 +170,11 @@ static void create_pbtn_text_surface(RobTkPBtn * d, const char * txt, PangoFontD
 
 	float c_col[4];
 	get_color_from_theme(0, c_col);
-	write_text_full(cr, txt, font,
+	PangoFontDescription *font = get_font_from_theme();
+	write_text_full(cr, d->txt, font,
 			d->w_width / 2.0 + 1,
 			d->w_height / 2.0 + 1, 0, 2, c_col);
+	pango_font_description_free(font);
 	cairo_destroy (cr);
 }
 
@@ -211,6 +222,8 @@ static RobTkPBtn * robtk_pbtn_new(const char * txt) {
 	d->btn_active = NULL;
 	d->btn_inactive = NULL;
 	d->sf_txt = NULL;
+	d->sf_scale = 1.0;
+	d->txt = strdup(txt);
 
 	int ww, wh;
 	PangoFontDescription *fd = get_font_from_theme();
@@ -221,8 +234,8 @@ static RobTkPBtn * robtk_pbtn_new(const char * txt) {
 	d->l_width = d->w_width;
 	d->l_height = d->w_height;
 
-	create_pbtn_text_surface(d, txt, fd);
 	pango_font_description_free(fd);
+	create_pbtn_text_surface(d);
 
 	d->rw = robwidget_new(d);
 	ROBWIDGET_SETNAME(d->rw, "pbtn");
@@ -245,6 +258,7 @@ static void robtk_pbtn_destroy(RobTkPBtn *d) {
 	cairo_pattern_destroy(d->btn_active);
 	cairo_pattern_destroy(d->btn_inactive);
 	cairo_surface_destroy(d->sf_txt);
+	free(d->txt);
 	free(d);
 }
 
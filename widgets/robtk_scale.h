@@ -45,6 +45,7 @@ typedef struct {
 	cairo_pattern_t* dpat;
 	cairo_pattern_t* fpat;
 	cairo_surface_t* bg;
+	float bg_scale;
 
 	float w_width, w_height;
 	bool horiz;
@@ -283,8 +284,8 @@ static void robtk_scale_render_metrics(RobTkScale* d) {
 	if (d->bg) {
 		cairo_surface_destroy(d->bg);
 	}
-	d->bg = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, d->w_width, d->w_height);
-	cairo_t *cr = cairo_create (d->bg);
+	cairo_t *cr;
+	d->bg = rtk_cache_surface_create (d->w_width, d->w_height, d->bg_scale, &cr);
 	cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
 	cairo_set_source_rgba (cr, .0, .0, .0, 0);
 	cairo_rectangle (cr, 0, 0, d->w_width, d->w_height);
@@ -326,9 +327,11 @@ static bool robtk_scale_expose_event (RobWidget* handle, cairo_t* cr, cairo_rect
 	cairo_fill(cr);
 
 	/* prepare tick mark surfaces */
-	if (d->mark_cnt > 0 && d->mark_expose) {
+	const float bg_scale = rtk_cache_scale(cr);
+	if (d->mark_cnt > 0 && (d->mark_expose || bg_scale != d->bg_scale)) {
 		pthread_mutex_lock (&d->_mutex);
 		d->mark_expose = FALSE;
+		d->bg_scale = bg_scale;
 		robtk_scale_render_metrics(d);
 		pthread_mutex_unlock (&d->_mutex);
 	}
@@ -341,7 +344,7 @@ static bool robtk_scale_expose_event (RobWidget* handle, cairo_t* cr, cairo_rect
 		} else {
 			cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
 		}
-		cairo_set_source_surface(cr, d->bg, 0, 0);
+		rtk_set_source_cache(cr, d->bg, 0, 0, d->bg_scale);
 		cairo_paint (cr);
 	}
 
@@ -471,6 +474,7 @@ static RobTkScale * robtk_scale_new_with_size(float min, float max, float step,
 	d->prelight = FALSE;
 	d->drag_x = d->drag_y = -1;
 	d->bg  = NULL;
+	d->bg_scale = 1.0;
 	create_scale_pattern(d);
 
 	d->mark_cnt = 0;
@@ -481,6 +485,7 @@ static RobTkScale * robtk_scale_new_with_size(float min, float max, float step,
 	robwidget_set_size_allocate(d->rw, robtk_scale_size_allocate);
 
 	robwidget_set_expose_event(d->rw, robtk_scale_expose_event);
+	robwidget_set_opaque(d->rw, TRUE);
 	robwidget_set_mouseup(d->rw, robtk_scale_mouseup);
 	robwidget_set_mousedown(d->rw, robtk_scale_mousedown);
 	robwidget_set_mousemove(d->rw, robtk_scale_mousemove);
@@ -557,5 +562,6 @@ static void robtk_scale_add_mark(RobTkScale *d, float v, const char *txt) {
 	d->mark_cnt++;
 	d->mark_expose = TRUE;
 	pthread_mutex_unlock (&d->_mutex);
+	robwidget_size_changed(d->rw);
 }
 #endif